@@ -0,0 +1,50 @@
+#pragma once
+
+#include "schedule_cache.hpp"
+#include "scheduler.hpp"
+#include <string>
+#include <vector>
+
+// Traced training graphs repeat the same layer block many times, laid out back to back in id
+// order. These helpers find such runs, search one representative per distinct block shape and
+// replay its order (recomputations included) on every instance.
+
+// `count` structurally identical instances at start, start + length, start + 2 * length, ...
+struct RepeatedBlock {
+    NodeId start{0};
+    uint32_t length{0};
+    uint32_t count{0};
+    uint64_t hash{0}; // blockHash of the first instance
+};
+
+struct BlockOptions {
+    uint32_t min_length{3};
+    uint32_t max_length{1024};
+    size_t max_candidates{64};     // block lengths tried per start position
+    size_t max_expansions{200000}; // dfs budget per representative
+    double time_limit{1.0};
+    ScheduleCache* cache{nullptr}; // consulted per shape before searching, updated after
+    bool relax_budget{false};      // search shapes with no budget left under total_memory (seeds only)
+};
+
+// Op type of a name stem: "Transpose-op3" -> "Transpose"
+std::string opType(const std::string& stem);
+
+// Canonical hash of ids [start, start + length): op types, sizes and, per input,
+// either its offset inside the block or a boundary marker. Equal for isomorphic instances.
+uint64_t blockHash(const Problem& prob, NodeId start, uint32_t length);
+
+// Greedy left-to-right scan for the longest-covering run of repeats at each position.
+// Requires inputs to precede their consumers in id order; returns nothing otherwise.
+std::vector<RepeatedBlock> findRepeatedBlocks(const Problem& prob, const BlockOptions& opts);
+
+// Schedules one representative per distinct block hash with dfsScheduleLimited (prioritySchedule
+// if that fails) under the budget left by the memory live into its instances, maps the order to
+// every instance, keeps id order elsewhere and replays the result with replaySchedule. Outputs
+// read after a block are charged inside its search until the block ends. Returns an empty
+// (incomplete) state when the id-order live-in of some shape already reaches total_memory, unless
+// relax_budget is set: then that shape is searched under total_memory and the replay only serves
+// as a first-run order for tabu, remat and storage. The replay can still exceed total_memory (a
+// failed search, boundary inputs freed mid-block); callers check memory_peak.
+ScheduleState blockReplicatedSchedule(const Problem& prob, const BlockOptions& opts,
+                                      std::vector<RepeatedBlock>* found = nullptr);
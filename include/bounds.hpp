@@ -0,0 +1,19 @@
+#pragma once
+
+#include "model.hpp"
+
+// Hard lower bounds every schedule of a Problem must respect, computed in O(N+E).
+struct ScheduleBounds {
+    long peak{0};             // largest single-node need: distinct inputs + run_mem + output_mem
+    NodeId peak_node{kNoNode};
+    long time{0};             // sum of time_cost plus forced_recompute
+    long forced_recompute{0}; // time some recomputation must add under total_memory
+};
+
+// forced_recompute looks at the two largest inputs a, b of every node: whichever runs first
+// keeps its output resident while the other runs, so if neither order fits in total_memory
+// one of them is recomputed. The largest such minimum over all nodes is a valid bound.
+ScheduleBounds computeScheduleBounds(const Problem& prob);
+
+// No schedule exists when a single node needs more than the budget.
+inline bool boundsFeasible(const Problem& prob, const ScheduleBounds& b) { return b.peak <= prob.total_memory; }
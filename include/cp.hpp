@@ -0,0 +1,42 @@
+#pragma once
+
+#include "scheduler.hpp"
+
+// Constraint-programming search for medium graphs. The decision variables are the node placed
+// at each position: a first run, or a recompute copy once nothing else fits. Each dropped output
+// adds a keep/recompute decision. Propagation at every search node:
+//  - precedence: only nodes whose inputs are resident are candidates (CSR inputs)
+//  - memory: a node needs its inputs, run and output memory plus every resident output pinned
+//    by a consumer that must run after it; above total_memory this forces a recomputation,
+//    raising the time bound (computeScheduleBounds rejects infeasible budgets up front)
+//  - bound: time so far + remainingTimeLowerBound + forced recomputation vs the incumbent
+// A subtree explored to the end records its state as a nogood (TranspositionTable). The value
+// order is priorityScore, and the incumbent is seeded from prioritySchedule.
+//
+// Limits: the "nogoods" are a closed list of fully explored states keyed by the 64-bit hash of
+// (computed, resident, first droppable id), not learned conflict explanations; a state is pruned
+// only when the same key was exhausted at no more time and peak. The move set is restricted:
+// recomputes only when no first run fits, drops only when no move fits and in increasing id
+// order, interchangeable nodes in canonical order. Optimality and lower_bound hold for schedules
+// this move set can produce, not for every valid schedule.
+struct CpOptions {
+    size_t max_nodes{200000};
+    double time_limit{5.0};
+    size_t nogood_entries{1u << 20};
+    PriorityWeights weights = defaultPriorityWeights();
+};
+
+struct CpStats {
+    size_t nodes{0};
+    size_t failures{0};      // memory propagation wiped out every move
+    size_t nogood_hits{0};
+    size_t bound_prunes{0};
+    long lower_bound{0};     // no schedule within the restricted move set is faster
+    long upper_bound{-1};    // time of the returned schedule, -1 without one
+    bool infeasible{false};  // some node alone exceeds total_memory
+    double gap() const {
+        return upper_bound > 0 ? static_cast<double>(upper_bound - lower_bound) / static_cast<double>(upper_bound) : 1.0;
+    }
+};
+
+ScheduleState cpSchedule(const Problem& prob, const CpOptions& opts, CpStats* stats = nullptr);
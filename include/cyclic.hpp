@@ -0,0 +1,44 @@
+#pragma once
+
+#include "scheduler.hpp"
+#include <functional>
+#include <vector>
+
+// Steady-state scheduling for a graph that runs once per training iteration. Sources (nodes
+// without inputs: parameters, constants) produce the same output every iteration. A carried
+// source is computed once during warm-up and stays resident across iteration boundaries:
+// steady-state iterations skip it, but its output occupies memory for the whole iteration.
+// Every other output lives within a single iteration, as in the one-pass model.
+//
+// Carrying therefore turns a source's per-iteration time into a constant memory offset. The
+// steady-state iteration is the original graph without the carried sources, scheduled under
+// total_memory minus their outputs by any one-pass scheduler.
+struct CyclicOptions {
+    size_t max_probes{8};                  // steady-state schedules tried while picking the carried set
+    const NodeBitset* candidates{nullptr}; // sources allowed to be carried; null = all of them
+};
+
+struct CyclicStats {
+    size_t candidates{0};
+    size_t carried{0};
+    size_t probes{0};
+    long carried_memory{0};
+    long warmup_time{0};  // first iteration: carried sources, then one steady-state iteration
+    long warmup_peak{0};
+    long steady_time{0};  // every later iteration
+    long steady_peak{0};
+    bool fits{false};
+};
+
+using IterationScheduler = std::function<ScheduleState(const Problem&)>;
+
+// `prob` without the `carried` nodes and their edges, budget reduced by their outputs.
+// `original` maps its ids back to `prob`'s. Carried nodes must not have inputs.
+Problem steadyStateProblem(const Problem& prob, const NodeBitset& carried, std::vector<NodeId>& original);
+
+// Picks the carried set from the candidates ranked by time saved per byte held: the longest
+// prefix whose steady-state schedule fits, found by binary search with `schedule`. Returns the
+// steady-state iteration in `prob`'s ids; memory_peak and current_memory include the carried
+// outputs, which are resident (and computed) throughout.
+ScheduleState cyclicSchedule(const Problem& prob, const IterationScheduler& schedule, const CyclicOptions& opts,
+                             CyclicStats* stats = nullptr, NodeBitset* carried = nullptr);
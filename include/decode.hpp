@@ -0,0 +1,66 @@
+#pragma once
+
+#include "scheduler.hpp"
+#include <vector>
+
+// List-scheduler decode of a topological first-run order, shared by decodeDrops,
+// decodeStoragePlan and decodeTierPlan. Entry i runs order[i] after materializing its missing
+// inputs (restoring a stored copy where the policy has one, recomputing otherwise). Outputs the
+// policy does not keep leave at the end of the entry that ran or restored them, or one entry
+// later when the next entry reads them.
+//
+// The policy supplies:
+//   void enter(size_t i)         entry i starts
+//   bool onDemand(NodeId v)      v does not run at its place, only when a consumer needs it
+//   bool kept(NodeId id)         id's output stays resident until its last use
+//   void beforeRun(NodeId id)    ahead of applyNode(id)
+//   void afterRun(NodeId id)     after applyNode(id)
+//   bool restore(NodeId y)       brings back a stored copy of y; false when there is none
+//   void release(NodeId x)       x leaves the device (spill, encode, offload, ...)
+// Returns false when a recompute cascade cannot be resolved or the order is incomplete.
+template <class Policy>
+bool decodeFirstRunOrder(const Problem& prob, const std::vector<NodeId>& order, ScheduleState& s, Policy& policy) {
+    const size_t maxSteps = 8 * prob.size() + 16; // bounds recompute cascades
+    std::vector<NodeId> held, carry, stack; // carry: held over into the next entry
+    auto run = [&](NodeId id) {
+        policy.beforeRun(id);
+        applyNode(id, prob, s);
+        policy.afterRun(id);
+        if (prob.consumers(id).empty()) spillOutput(prob, s, id);
+        else if (!policy.kept(id)) held.push_back(id);
+    };
+    // Runs `x` after materializing its missing inputs, depth first with an explicit stack
+    auto ensure = [&](NodeId x) {
+        stack.assign(1, x);
+        while (!stack.empty()) {
+            NodeId y = stack.back();
+            if (s.resident.test(y)) { stack.pop_back(); continue; }
+            if (policy.restore(y)) { stack.pop_back(); held.push_back(y); continue; }
+            bool ready = true;
+            for (NodeId z : prob.inputs(y)) {
+                if (!s.resident.test(z)) { stack.push_back(z); ready = false; }
+            }
+            if (ready) { stack.pop_back(); run(y); }
+            if (s.execution_order.size() > maxSteps) return false;
+        }
+        return true;
+    };
+    for (size_t i = 0; i < order.size(); ++i) {
+        policy.enter(i);
+        NodeId v = order[i];
+        if (s.computed.test(v) || (policy.onDemand(v) && !prob.consumers(v).empty())) continue;
+        if (!ensure(v)) return false;
+        for (NodeId x : held) {
+            if (!s.resident.test(x) || !hasPendingConsumer(prob, x, s)) continue;
+            bool nextUses = false;
+            if (i + 1 < order.size()) {
+                for (NodeId in : prob.inputs(order[i + 1])) if (in == x) { nextUses = true; break; }
+            }
+            if (nextUses) carry.push_back(x);
+            else policy.release(x);
+        }
+        held.swap(carry);
+        carry.clear();
+    }
+    return s.computed.count() == prob.size();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "model.hpp"
+#include <array>
+#include <string>
+
+// Cheap O(N+E) graph statistics used to pick a scheduler (see selector.hpp).
+enum GraphFeature {
+    GF_Nodes = 0,
+    GF_Edges,
+    GF_MaxFanIn,
+    GF_Width,          // largest number of nodes sharing a longest-path level
+    GF_BudgetRatio,    // total_memory / peak of a topological sweep that frees inputs after last use
+    GF_ChainFraction,  // fraction of nodes with at most one input and at most one consumer
+    GF_Count
+};
+
+struct GraphFeatures {
+    std::array<double, GF_Count> v{};
+};
+
+GraphFeatures computeGraphFeatures(const Problem& prob);
+const char* graphFeatureName(int feature);
+int graphFeatureIndex(const std::string& name); // -1 when unknown
+
+// Peak of the FIFO topological order with last-use freeing; used for GF_BudgetRatio.
+long topologicalSweepPeak(const Problem& prob);
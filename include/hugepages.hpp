@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Huge-page backing for the large, randomly accessed buffers: graph columns (Problem) and
+// transposition tables. Buffers of at least kHugePageBytes are mapped directly, 2 MiB aligned,
+// whatever the mode, so they can be released the same way; the mode only decides how they are
+// backed. Smaller buffers use operator new.
+//
+// Off          plain anonymous mapping (the kernel's THP default still applies)
+// Transparent  madvise(MADV_HUGEPAGE)
+// Explicit     MAP_HUGETLB from the reserved pool (vm.nr_hugepages), Transparent when it is empty
+enum class HugePageMode { Off, Transparent, Explicit };
+
+constexpr size_t kHugePageBytes = size_t{2} << 20;
+
+bool parseHugePageMode(const std::string& text, HugePageMode& out); // off | thp | explicit
+const char* hugePageModeName(HugePageMode mode);
+// Applies to allocations made afterwards.
+void setHugePageMode(HugePageMode mode);
+HugePageMode hugePageMode();
+
+struct HugePageStats {
+    size_t explicit_bytes{0};    // MAP_HUGETLB mappings
+    size_t transparent_bytes{0}; // advised with MADV_HUGEPAGE
+    size_t plain_bytes{0};       // mapped without advice, or advice refused
+    size_t fallbacks{0};         // explicit requests served by a smaller page size
+};
+// Bytes currently mapped per backing; the kernel may still split or refuse THP.
+HugePageStats hugePageStats();
+
+void* allocateHugeCapable(size_t bytes);
+void deallocateHugeCapable(void* p, size_t bytes);
+
+template <class T>
+struct HugePageAllocator {
+    using value_type = T;
+    HugePageAllocator() = default;
+    template <class U> HugePageAllocator(const HugePageAllocator<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(allocateHugeCapable(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { deallocateHugeCapable(p, n * sizeof(T)); }
+};
+template <class T, class U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+template <class T>
+using HugeVector = std::vector<T, HugePageAllocator<T>>;
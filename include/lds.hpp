@@ -0,0 +1,33 @@
+#pragma once
+
+#include "scheduler.hpp"
+
+// Alternative drivers over dfsScheduleLimited's branching (heuristicMoves / spillForProgress)
+// that spread the expansion budget across the tree instead of spending it in the leftmost part.
+// Both run on several threads sharing one incumbent, whose time bounds every worker's search.
+struct DiversifiedOptions {
+    size_t max_expansions{200000}; // shared by all workers
+    double time_limit{5.0};
+    size_t threads{0};             // 0 = defaultThreadCount()
+    size_t max_discrepancies{16};  // lds: iterations 0..max, one per work item
+    size_t luby_unit{64};          // restarts: expansions per Luby unit
+    uint64_t seed{1};
+    size_t shared_entries{0};      // restarts: lock-free table of fully searched states shared by all runs; 0 = none (runStrategy sets it with > 1 thread)
+    bool numa{true};               // multi-node hosts: workers pinned per NUMA node, each node with its own graph copy
+};
+
+struct DiversifiedStats {
+    size_t expansions{0}; // over all workers
+};
+
+// Limited discrepancy search: iteration k explores every path that leaves the heuristic order
+// at most k times (taking any child but the first costs one). Iterations run in parallel.
+ScheduleState ldsSchedule(const Problem& prob, const DiversifiedOptions& opts, DiversifiedStats* stats = nullptr);
+
+// Randomized restarts: run r is a depth-first search whose move order is perturbed by a
+// seed-dependent coin (each move swaps with its successor with probability 1/4), cut off
+// after luby(r) * luby_unit expansions. Runs are spread over the threads.
+ScheduleState restartSchedule(const Problem& prob, const DiversifiedOptions& opts, DiversifiedStats* stats = nullptr);
+
+// Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., i starting at 0
+size_t lubyTerm(size_t i);
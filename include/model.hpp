@@ -1,51 +1,153 @@
 #pragma once
 
+#include "hugepages.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <string>
-#include <vector>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
+using NodeId = uint32_t;
+constexpr NodeId kNoNode = 0xFFFFFFFFu;
+
+// Per-node costs only; names and graph structure live in Problem.
 class Node {
 private:
-    std::string name_;
-    std::vector<std::string> input_names_;
     int run_mem_;
     int output_mem_;
     int time_cost_;
-    int peak_;
-    int impact_;
 public:
-    Node() : run_mem_(0), output_mem_(0), time_cost_(0), peak_(0), impact_(0) {}
-    Node(std::string name, std::vector<std::string> inputs, int run_mem, int output_mem, int time_cost)
-        : name_(std::move(name)), input_names_(std::move(inputs)), run_mem_(run_mem), output_mem_(output_mem), time_cost_(time_cost) {
-        peak_ = std::max(run_mem_, output_mem_);
-        impact_ = output_mem_;
-    }
-    const std::string& getName() const { return name_; }
-    const std::vector<std::string>& getInputs() const { return input_names_; }
+    Node() : run_mem_(0), output_mem_(0), time_cost_(0) {}
+    Node(int run_mem, int output_mem, int time_cost)
+        : run_mem_(run_mem), output_mem_(output_mem), time_cost_(time_cost) {}
     int getRunMem() const { return run_mem_; }
     int getOutputMem() const { return output_mem_; }
     int getTimeCost() const { return time_cost_; }
-    int getPeak() const { return peak_; }
-    int getImpact() const { return impact_; }
-    void setImpact(int impact) { impact_ = impact; }
+    int getPeak() const { return std::max(run_mem_, output_mem_); }
+};
+
+// Node names interned as a shared stem plus an optional numeric suffix. parseExamplesFormat names
+// every node "<Op>-op<k>_id<i>", so a 10M-node graph stores a few hundred stems and 8 bytes per node.
+class NameTable {
+public:
+    static constexpr uint32_t kNoSuffix = 0xFFFFFFFFu; // numeric suffixes must stay below
+private:
+    std::vector<std::string> stems_;
+    std::unordered_map<std::string, uint32_t> stem_index_;
+    std::vector<uint32_t> stem_of_;
+    std::vector<uint32_t> suffix_;
+    uint32_t intern(const std::string& stem);
+public:
+    void reserve(size_t n) { stem_of_.reserve(n); suffix_.reserve(n); }
+    // Appends the name for the next node id; "<stem>_id<digits>" is split, anything else kept whole.
+    void add(const std::string& name);
+    void add(const std::string& stem, uint32_t id_suffix);
+    std::string name(NodeId id) const;
+    const std::string& stem(NodeId id) const { return stems_[stem_of_[id]]; }
+    size_t size() const { return stem_of_.size(); }
+    size_t bytesUsed() const;
+};
+
+// One execution step packed into 32 bits: node id in the low 31 bits, recompute flag in the top bit
+// (set when the step re-runs a previously executed node to restore its output).
+class ScheduleStep {
+private:
+    uint32_t packed_;
+    static constexpr uint32_t kRecomputeBit = 0x80000000u;
+public:
+    static constexpr size_t kMaxNodes = kRecomputeBit; // loaders reject larger graphs
+    ScheduleStep(NodeId node, bool recompute) : packed_(node | (recompute ? kRecomputeBit : 0u)) {}
+    NodeId node() const { return packed_ & ~kRecomputeBit; }
+    bool isRecompute() const { return (packed_ & kRecomputeBit) != 0; }
+};
+
+// Dense set of node ids; grows on demand so a default-constructed state needs no sizing.
+class NodeBitset {
+private:
+    std::vector<uint64_t> words_;
+    size_t count_{0};
+public:
+    bool test(NodeId id) const {
+        size_t w = id >> 6;
+        return w < words_.size() && ((words_[w] >> (id & 63)) & 1u);
+    }
+    void set(NodeId id) {
+        size_t w = id >> 6;
+        if (w >= words_.size()) words_.resize(w + 1, 0);
+        uint64_t bit = uint64_t{1} << (id & 63);
+        if (!(words_[w] & bit)) { words_[w] |= bit; ++count_; }
+    }
+    void reset(NodeId id) {
+        size_t w = id >> 6;
+        if (w >= words_.size()) return;
+        uint64_t bit = uint64_t{1} << (id & 63);
+        if (words_[w] & bit) { words_[w] &= ~bit; --count_; }
+    }
+    size_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    const std::vector<uint64_t>& words() const { return words_; }
+    template <typename F>
+    void forEach(F&& f) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            for (uint64_t bits = words_[w]; bits; bits &= bits - 1) {
+                f(static_cast<NodeId>((w << 6) | static_cast<size_t>(__builtin_ctzll(bits))));
+            }
+        }
+    }
 };
 
 struct ScheduleState {
-    std::vector<std::string> execution_order;
-    std::vector<bool> recompute_flags; // true if this step is a recomputation of a previously executed node
-    int current_memory{0};
-    int memory_peak{0};
-    int total_time{0};
-    std::unordered_set<std::string> computed;
-    std::unordered_map<std::string, int> output_memory;
+    std::vector<ScheduleStep> execution_order;
+    long current_memory{0};
+    long memory_peak{0};
+    long total_time{0};
+    NodeBitset computed; // ran at least once
+    NodeBitset resident; // output currently held in memory (size is the node's output_mem)
 };
 
-struct Problem {
-    long total_memory{0};
-    std::unordered_map<std::string, Node> nodes;
-    std::unordered_map<std::string, std::unordered_set<std::string>> dependencies; // input -> consumers
-    std::unordered_map<std::string, std::vector<std::string>> successors; // node -> consumers list
+// Ways to hold an output between uses other than keeping it or recomputing it (see storage.hpp).
+// Times are charged per transition; -1 marks an option the op does not support.
+struct StorageCosts {
+    int compressed_mem{-1}; // bytes while encoded
+    int encode_time{0};
+    int decode_time{0};
+    int transfer_time{-1};  // one direction of an offload to host memory
 };
 
+// Contiguous slice of a CSR id array
+struct IdRange {
+    const NodeId* first;
+    const NodeId* last;
+    const NodeId* begin() const { return first; }
+    const NodeId* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// Graph in compressed sparse row form, indexed by NodeId. Inputs and consumers are the two
+// directions of the same edge set; nothing else stores adjacency. The columns searches read at
+// random are huge-page capable (hugepages.hpp).
+struct Problem {
+    long total_memory{0};
+    HugeVector<Node> nodes;
+    NameTable names;
+    HugeVector<uint32_t> input_offsets{0};    // inputs of i: input_ids[input_offsets[i], input_offsets[i+1])
+    HugeVector<NodeId> input_ids;
+    HugeVector<uint32_t> consumer_offsets{0}; // consumers of i, same layout
+    HugeVector<NodeId> consumer_ids;
+    // Op semantics from the registry (applyOpRegistry); empty when none was loaded
+    std::vector<int> recompute_cost;           // time charged when i is re-run; empty = time_cost
+    NodeBitset in_place;                       // outputs written over the first input when it dies at that step
+    std::vector<StorageCosts> storage;         // compress / offload options per output; empty = none
 
+    size_t size() const { return nodes.size(); }
+    IdRange inputs(NodeId id) const {
+        return {input_ids.data() + input_offsets[id], input_ids.data() + input_offsets[id + 1]};
+    }
+    IdRange consumers(NodeId id) const {
+        return {consumer_ids.data() + consumer_offsets[id], consumer_ids.data() + consumer_offsets[id + 1]};
+    }
+    int recomputeCost(NodeId id) const { return recompute_cost.empty() ? nodes[id].getTimeCost() : recompute_cost[id]; }
+    std::string name(NodeId id) const { return names.name(id); }
+    size_t bytesUsed() const;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "model.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// NUMA placement for the parallel searches, read from /sys/devices/system/node without libnuma.
+// Memory follows first touch: a thread pinned to a node allocates and writes its pages there,
+// so per-worker allocations (search states, glibc's per-thread arenas) land locally once the
+// worker is pinned, and a graph copied by a pinned thread is a node-local replica.
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus; // per node, the CPUs this process may run on
+    size_t nodes() const { return node_cpus.size(); }
+    bool multiNode() const { return node_cpus.size() > 1; }
+};
+
+// Nodes with at least one allowed CPU. Where the topology is unavailable (non-Linux, no sysfs)
+// a single node with an empty CPU list, on which pinning is a no-op.
+NumaTopology detectNumaTopology();
+// Restricts the calling thread to `cpus`; false when unsupported or `cpus` is empty.
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+// One read-only copy of a Problem per node, each built by a thread pinned there. With a single
+// node every node shares the original.
+class ProblemReplicas {
+public:
+    ProblemReplicas(const Problem& prob, const NumaTopology& topo);
+    const Problem& local(size_t node) const { return node < copies_.size() && copies_[node] ? *copies_[node] : prob_; }
+
+private:
+    const Problem& prob_;
+    std::vector<std::unique_ptr<Problem>> copies_;
+};
+
+// parallelFor with every worker on its own thread, worker w pinned to node w % nodes: runs
+// body(i, worker, node) for i in [0, count) on `threads` workers (0 = every allowed CPU).
+template <class Body>
+void numaParallelFor(size_t count, size_t threads, const NumaTopology& topo, Body&& body) {
+    if (threads == 0) {
+        for (const auto& cpus : topo.node_cpus) threads += cpus.size();
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, count));
+    const size_t nodes = std::max<size_t>(1, topo.nodes());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < threads; ++w) {
+        pool.emplace_back([&, w] {
+            const size_t node = w % nodes;
+            if (topo.multiNode()) pinCurrentThread(topo.node_cpus[node]);
+            for (size_t i = next++; i < count; i = next++) body(i, w, node);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
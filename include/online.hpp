@@ -0,0 +1,96 @@
+#pragma once
+
+#include "parser.hpp"
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Online scheduler for graphs that become known one node at a time (eager / JIT execution).
+// Specs arrive in a topological order; each must name only inputs that arrived earlier. Up to
+// `lookahead` arrived nodes are held back, and the oldest runs as soon as the window is full,
+// so decisions depend only on what has arrived.
+//
+// Consumer counts are unknown, so nothing is freed early: outputs stay resident until memory is
+// needed. Eviction takes the least recently used output not referenced by any node in the
+// window (cold), then the least recently used one that is (warm). An evicted output that a later
+// node reads is recomputed first, along with its own missing inputs. Both lists are intrusive
+// and hash lookups happen once per input, so the work per arrival is O(inputs) plus O(1) per
+// action (each eviction pays for an earlier run).
+struct OnlineOptions {
+    size_t lookahead{16}; // arrived nodes held back before the oldest must run
+};
+
+enum class OnlineActionKind { Run, Recompute, Spill, Free };
+
+// Spill: evicted under memory pressure (recomputed if a later node reads it).
+// Free: released by finish() once the stream has ended.
+struct OnlineAction {
+    OnlineActionKind kind;
+    NodeId node; // arrival index
+};
+
+struct OnlineStats {
+    size_t nodes{0};
+    size_t runs{0};
+    size_t recomputes{0};
+    size_t spills{0};
+    size_t frees{0};
+    size_t over_budget{0}; // runs that did not fit even after evicting everything unpinned
+    long total_time{0};
+    long memory_peak{0};
+};
+
+class OnlineScheduler {
+public:
+    using Sink = std::function<void(const OnlineAction&)>;
+
+    OnlineScheduler(long total_memory, const OnlineOptions& opts, Sink sink = nullptr);
+
+    // False (nothing changes) when an input names a node that has not arrived.
+    bool push(const ParsedNodeSpec& spec, std::string& error);
+    // End of stream: runs the held-back nodes and frees every resident output.
+    void finish();
+
+    const OnlineStats& stats() const { return stats_; }
+    std::string name(NodeId id) const { return names_.name(id); }
+
+private:
+    enum List : uint8_t { kNone, kCold, kWarm };
+    struct Chain {
+        NodeId head{kNoNode}, tail{kNoNode};
+        size_t size{0};
+    };
+
+    void runOldest();
+    void materialize(NodeId v);
+    void runNode(NodeId id);
+    bool evictOne(Chain& chain);
+    void release(NodeId id, OnlineActionKind kind);
+    void link(NodeId id, List list);
+    void unlink(NodeId id);
+    void touch(NodeId id);
+    Chain& chain(List list) { return list == kCold ? cold_ : warm_; }
+    void emit(OnlineActionKind kind, NodeId id) { if (sink_) sink_({kind, id}); }
+
+    long total_memory_;
+    OnlineOptions opts_;
+    Sink sink_;
+    OnlineStats stats_;
+    long current_{0};
+
+    NameTable names_;
+    std::unordered_map<std::string, NodeId> ids_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> input_offsets_{0};
+    std::vector<NodeId> input_ids_; // distinct inputs per node
+    std::vector<uint32_t> window_uses_; // readers among the held-back nodes
+    std::vector<uint32_t> pins_;        // readers waiting on the recompute stack
+    std::vector<uint8_t> computed_;
+    std::vector<uint8_t> list_;         // List holding a resident output; kNone when absent
+    std::vector<NodeId> prev_, next_;
+    Chain cold_, warm_;
+    std::deque<NodeId> window_;         // held-back arrivals, oldest first
+    std::vector<NodeId> stack_;
+};
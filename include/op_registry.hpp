@@ -0,0 +1,57 @@
+#pragma once
+
+#include "model.hpp"
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+
+// Per-op-type semantics the sizes in the input file do not carry. Types are derived from the
+// name stem (opType: "MatMul-op12" -> "MatMul") and described in a text file, one type per line:
+//
+//     # type   key=value ...
+//     *        recompute=1.0            # defaults for every type not listed
+//     Equal    recompute=0.5 in_place=1
+//     Conv     workspace=0.25 workspace_min=4096 offload=0.8 transfer=40
+//     Relu     compress=0.25 encode=8 decode=6
+//
+// recompute      multiplier on time_cost when the node is re-run (kernels fused on replay, or a
+//                cached algorithm choice, make recomputation cheaper than the first run)
+// in_place       the output may overwrite the node's first input when that input dies at the step
+// workspace      scratch memory during the run, as a fraction of output_mem
+// workspace_min  lower bound on that scratch, in bytes
+// offload        0..1 preference for moving the output off-device instead of recomputing it;
+//                0 = never offloaded
+// transfer       offload cost per direction, in time units per MiB of output
+// compress       encoded size as a fraction of output_mem; 0 = not compressible
+// encode, decode compression costs, in time units per MiB of output
+struct OpTraits {
+    double recompute{1.0};
+    bool in_place{false};
+    double workspace{0.0};
+    long workspace_min{0};
+    double offload{0.0};
+    double transfer{0.0};
+    double compress{0.0};
+    double encode{0.0};
+    double decode{0.0};
+};
+
+class OpRegistry {
+public:
+    bool load(std::istream& in, std::string& error);
+    // Traits of `type`, or the '*' defaults when it is not listed.
+    const OpTraits& traits(const std::string& type) const;
+    size_t size() const { return types_.size(); }
+
+private:
+    OpTraits defaults_;
+    std::unordered_map<std::string, OpTraits> types_;
+};
+
+bool loadOpRegistry(const std::string& path, OpRegistry& out, std::string& error);
+
+// Bakes the registry into `prob`'s cost model: workspace is added to run_mem, recompute
+// multipliers fill Problem::recompute_cost, in-place types Problem::in_place, and compress /
+// offload options Problem::storage (transfer time divided by the affinity). Returns the
+// number of nodes whose costs changed.
+size_t applyOpRegistry(const OpRegistry& reg, Problem& prob);
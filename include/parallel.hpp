@@ -0,0 +1,27 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// hardware_concurrency, or 1 when it is unknown
+inline size_t defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs body(i, worker) for i in [0, count) on `threads` workers (0 = defaultThreadCount()),
+// the calling thread included. Indices are handed out one at a time, so uneven items balance.
+template <class Body>
+void parallelFor(size_t count, size_t threads, Body&& body) {
+    if (threads == 0) threads = defaultThreadCount();
+    threads = std::max<size_t>(1, std::min(threads, count));
+    std::atomic<size_t> next{0};
+    auto worker = [&](size_t w) {
+        for (size_t i = next++; i < count; i = next++) body(i, w);
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+}
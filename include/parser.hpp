@@ -23,4 +23,46 @@ bool parseSimpleFormat(std::istream& in, long& total_memory,
 
 Problem buildProblem(long total_memory, const std::vector<ParsedNodeSpec>& specs);
 
+// Incremental CSR construction: add nodes in id order, each followed by its inputs.
+// Inputs that are only known later (forward references) go through addLateInput;
+// edges to ids that never receive a node are dropped by finish().
+class ProblemBuilder {
+public:
+    explicit ProblemBuilder(long total_memory) { prob_.total_memory = total_memory; }
+    void reserve(size_t nodes, size_t edges);
+    NodeId addNode(const std::string& name, int run_mem, int output_mem, int time_cost);
+    NodeId addNode(const std::string& stem, uint32_t id_suffix, int run_mem, int output_mem, int time_cost);
+    void addInput(NodeId input);
+    void addLateInput(NodeId consumer, NodeId input);
+    size_t size() const { return prob_.nodes.size(); }
+    Problem finish();
+private:
+    Problem prob_;
+    std::vector<std::pair<NodeId, NodeId>> late_inputs_;
+};
+
+// One data row of the examples format, in the file's own id numbering. loadExamplesProblem
+// rejects ids outside [0, 2^32 - 1) and ignores repeated input ids on a row.
+struct ExamplesRow {
+    long id{-1};
+    std::string name;
+    std::vector<long> inputs; // missing ids read as -1
+    long run_mem{0};
+    long output_mem{0};
+    long time_cost{0};
+};
+
+bool parseExamplesHeader(const std::string& line, long& total_memory);
+// False for lines that are not node rows (blank or malformed); sizes are clamped at zero.
+bool parseExamplesRow(const std::string& line, ExamplesRow& row);
+
+// Reads the examples format straight into the CSR representation without materializing
+// ParsedNodeSpec strings; this is the loader used for very large graphs.
+bool loadExamplesProblem(std::istream& in, Problem& out, std::string& error);
+
+// Reads a file in either supported format (examples format first, then simple format).
+bool loadProblemFile(const std::string& path, Problem& out, std::string& error);
 
+// Writes `prob` in the examples format with NodeIds as file ids and name stems as names, so
+// loadExamplesProblem reads back the same graph (names "<stem>_id<i>" round-trip exactly).
+bool saveExamplesProblem(const std::string& path, const Problem& prob, std::string& error);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+// Hardware counters around a region of the benchmark, through perf_event_open. Each event is
+// opened on its own with inherit set, so worker threads started inside the region are counted,
+// and its value is scaled by time enabled / time running when the PMU multiplexes. Events the
+// kernel refuses (perf_event_paranoid, containers, VMs without a virtual PMU, non-Linux) are
+// reported as unavailable instead of failing the run.
+enum PerfEvent { PE_Cycles, PE_Instructions, PE_L1dMisses, PE_LlcMisses, PE_BranchMisses, PE_Count };
+
+const char* perfEventName(int event);
+
+struct PerfSample {
+    double value[PE_Count]{};
+    bool valid[PE_Count]{};
+    bool any() const {
+        for (bool v : valid) if (v) return true;
+        return false;
+    }
+};
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+    // Why the first unavailable event could not be opened; empty when all were.
+    const std::string& error() const { return error_; }
+
+    void start();
+    PerfSample stop();
+
+private:
+    int fd_[PE_Count];
+    std::string error_;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+// Features scored for every ready candidate by prioritySchedule.
+// Memory features are normalized by total_memory and time by the largest time_cost,
+// so one weight file can be shared across graphs of very different scale.
+enum PriorityFeature {
+    PF_DynamicImpact = 0,  // output_mem minus inputs released by running the node
+    PF_PredictedPeak,      // calculateSequentialPeak for the candidate
+    PF_TimeCost,
+    PF_OutputMem,
+    PF_RunMem,
+    PF_FanIn,              // number of inputs (normalized by the largest fan-in)
+    PF_FanOut,             // number of consumers (normalized by the largest fan-out)
+    PF_Count
+};
+
+// Linear priority: the ready node with the lowest weighted sum runs next.
+struct PriorityWeights {
+    std::array<double, PF_Count> w{};
+};
+
+// Weights reproducing heuristicSchedule's ordering: negative impact first, then peak, then time.
+PriorityWeights defaultPriorityWeights();
+const char* priorityFeatureName(int feature);
+
+// Weight file: one "<feature_name> <value>" per line, '#' starts a comment.
+// Missing features keep their default value.
+bool loadPriorityWeights(const std::string& path, PriorityWeights& out, std::string& error);
+bool savePriorityWeights(const std::string& path, const PriorityWeights& weights, std::string& error);
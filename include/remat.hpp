@@ -0,0 +1,31 @@
+#pragma once
+
+#include "scheduler.hpp"
+
+// Proactive rematerialization of cheap outputs. Ops such as Equal, Cast or ExpandDims produce
+// large outputs in very little time; holding them from their run to their last consumer costs
+// more memory than recomputing them. Every output whose output_mem / time_cost is at least the
+// threshold is dropped after each use and recomputed just before its next consumer (see
+// decodeDrops), instead of waiting for the searches to spill it once nothing fits.
+struct EagerRematOptions {
+    double threshold{0.0}; // bytes per unit of recompute time; 0 = tune against the budget
+    size_t max_probes{24}; // decodes spent tuning
+};
+
+struct EagerRematStats {
+    double threshold{0.0}; // the one used
+    size_t dropped{0};     // outputs at or above it
+    size_t probes{0};
+    bool fits{false};      // peak within total_memory
+};
+
+// Size-to-recompute-cost ratio of `id`'s output; nodes without consumers have nothing to drop.
+double rematRatio(const Problem& prob, NodeId id);
+// Outputs at or above `threshold`.
+NodeBitset cheapOutputs(const Problem& prob, double threshold);
+
+// Decodes firstRunOrder(seed) with cheapOutputs(threshold). Tuning binary-searches the ratio
+// ranking for the fewest drops (highest threshold) that fit the budget; when none fits, the
+// lowest peak seen is kept.
+ScheduleState eagerRematSchedule(const Problem& prob, const ScheduleState& seed, const EagerRematOptions& opts,
+                                 EagerRematStats* stats = nullptr, NodeBitset* dropped = nullptr);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "model.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Persistent store of the best known local schedules, keyed by a canonical subgraph hash
+// (blockHash) plus the budget left at the subgraph boundary when the order was searched.
+// An entry answers a request when it was searched under at least the requested budget and its
+// peak fits; one searched under a tighter budget stays valid but a fresh search may beat it,
+// so it is not returned. Lookups replay the matching entries on the region at hand (timings
+// are not part of the hash) and return the fastest.
+class ScheduleCache {
+public:
+    // A missing file is an empty cache, not an error.
+    bool load(const std::string& path, std::string& error);
+    // Writes `path`.tmp and renames it over `path`.
+    bool save(const std::string& path, std::string& error) const;
+
+    // Best cached order for `hash` that replays completely on `region` within `budget`.
+    bool lookup(uint64_t hash, const Problem& region, long budget, ScheduleState& out) const;
+    // Records a complete schedule of a region searched under `budget`; returns false when an
+    // entry searched under at least that budget is as good in both peak and time.
+    bool offer(uint64_t hash, long budget, const ScheduleState& s);
+
+    size_t size() const;
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    bool dirty() const { return dirty_; }
+
+private:
+    struct Entry {
+        long budget{0};
+        long peak{0};
+        long total_time{0};
+        std::vector<ScheduleStep> steps;
+    };
+    std::unordered_map<uint64_t, std::vector<Entry>> entries_;
+    mutable size_t hits_{0};
+    mutable size_t misses_{0};
+    bool dirty_{false};
+};
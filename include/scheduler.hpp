@@ -1,22 +1,107 @@
 #pragma once
 
 #include "model.hpp"
+#include "priority.hpp"
 
-int calculateSequentialPeak(const ScheduleState& state, const Node& node_B, int impact_A);
+// Peak of `state` after running `id` next (stepPeak, so in-place ops count); the move filter of the searches
+long calculateSequentialPeak(const Problem& prob, NodeId id, const ScheduleState& state);
 bool isBetterSchedule(const ScheduleState& state1, const ScheduleState& state2, long total_memory);
-std::unordered_set<std::string> getFreeableInputs(
-    const Node& node,
-    const ScheduleState& state,
-    const std::unordered_map<std::string, std::unordered_set<std::string>>& dependencies);
+// Total time relative to running every node exactly once; incomplete or over-budget
+// schedules score above 10 so they rank behind every valid one.
+double relativeScheduleCost(const Problem& prob, const ScheduleState& s);
+// Inputs of `node` that become dead once it runs (every consumer then computed).
+std::vector<NodeId> getFreeableInputs(const Problem& prob, NodeId node, const ScheduleState& state);
+// Memory in use while `id` runs on `state`: resident outputs plus max(run_mem, output_mem), where an
+// in-place op whose first input dies at this step writes into that input's buffer.
+long stepPeak(const Problem& prob, NodeId id, const ScheduleState& state);
+// Runs `id` in place: charges its peak, frees inputs whose consumers are all done, keeps its output.
+void applyNode(NodeId id, const Problem& prob, ScheduleState& state);
+// Re-simulates an execution order (recompute steps included) from scratch. Outputs that are not
+// used again, or whose next use is a recomputation, are dropped right after their previous use,
+// so spills implied by the order are charged correctly. Stops early at a step whose inputs are not resident.
+ScheduleState replaySchedule(const Problem& prob, const std::vector<ScheduleStep>& order);
+// The drops replaySchedule applies: (step, output) pairs in step order, each output released
+// right after that step. An output may appear twice at one step when it is also an input.
+std::vector<std::pair<size_t, NodeId>> releasePoints(const Problem& prob, const std::vector<ScheduleStep>& order);
+// Symmetry groups: nodes with the same (run, out, time), the same input set and the same
+// consumer set can be swapped in any schedule without changing its cost. Returns, per node,
+// the previous member of its group (kNoNode for the first); searches only let a node run for
+// the first time after that predecessor, so one permutation per group is explored.
+std::vector<NodeId> interchangeablePredecessors(const Problem& prob);
+
+// Move generation shared by the searches
+// Uncomputed nodes whose inputs are all resident.
+std::vector<NodeId> getReadyNodes(const Problem& prob, const ScheduleState& state);
+// Spilled outputs some pending consumer still needs whose inputs are resident (recomputable now).
+std::vector<NodeId> getRecomputeCandidates(const Problem& prob, const ScheduleState& state);
+// Output memory added minus resident inputs released if `id` ran now.
+long calculateDynamicImpact(const Problem& prob, NodeId id, const ScheduleState& state);
+bool hasPendingConsumer(const Problem& prob, NodeId id, const ScheduleState& state);
+// Drops a resident output; it has to be recomputed if needed again.
+void spillOutput(const Problem& prob, ScheduleState& state, NodeId id);
+// Drops every resident output no pending consumer needs.
+void garbageCollectOutputs(const Problem& prob, ScheduleState& state);
+
+// dfsScheduleLimited's branching at `state`: first runs (canonical within symmetry groups, see
+// interchangeablePredecessors), else recomputes, after its dynamic ready-list pruning, that fit
+// the budget, by increasing predicted peak. Empty when nothing fits.
+std::vector<NodeId> heuristicMoves(const Problem& prob, const ScheduleState& state, const std::vector<NodeId>& symPrev);
+// The spill dfsScheduleLimited falls back to when no move fits; false when nothing can be dropped.
+bool spillForProgress(const Problem& prob, ScheduleState& state);
+
+// Normalizers and per-candidate score behind prioritySchedule (lower runs first).
+struct PriorityScales {
+    double mem{1.0};
+    int max_time{1};
+    size_t max_fan_in{1};
+    size_t max_fan_out{1};
+};
+PriorityScales priorityScales(const Problem& prob);
+double priorityScore(const Problem& prob, const ScheduleState& state, NodeId id,
+                     const PriorityWeights& weights, const PriorityScales& scales);
 
 ScheduleState schedule(const Problem& prob);
 ScheduleState scheduleWithLimits(const Problem& prob, size_t maxExpansions, double timeLimitSeconds);
 ScheduleState greedySchedule(const Problem& prob);
-ScheduleState beamSearchSchedule(const Problem& prob, size_t beamWidth, size_t maxExpansions);
+// `expansions`, when given, receives the number of states generated.
+ScheduleState beamSearchSchedule(const Problem& prob, size_t beamWidth, size_t maxExpansions, size_t* expansions = nullptr);
 ScheduleState heuristicSchedule(const Problem& prob);
+ScheduleState prioritySchedule(const Problem& prob, const PriorityWeights& weights);
 ScheduleState dpGreedySchedule(const Problem& prob, size_t lookaheadDepth, size_t branchFactor);
 ScheduleState dfsScheduleLimited(const Problem& prob, size_t maxExpansions, double timeLimitSeconds);
 
+// Best-first search over the same moves as dfsScheduleLimited, ordered by f = g + weight * h
+// with g the time so far and h = remainingTimeLowerBound. weight 1 returns an optimal state;
+// a larger weight finds one sooner and, with anytime, keeps refining it until the open list
+// cannot beat the incumbent. The open list is bucketed by f, one value per bucket while f0 stays
+// below 131072; past that buckets pop out of f order and weight 1 searches on like anytime
+// instead of stopping at the first complete state. The closed list is a bounded
+// TranspositionTable. Past max_open states only the best half by f is kept (beam-style), which
+// gives up the optimality proof but not the search.
+struct AStarOptions {
+    double weight{1.0};
+    bool anytime{false};
+    size_t max_expansions{200000};
+    double time_limit{5.0};
+    size_t max_open{50000};
+    size_t table_entries{1u << 20};
+};
+
+struct AStarStats {
+    size_t expansions{0};
+    size_t generated{0};
+    size_t closed_hits{0};  // children dropped by the transposition table
+    size_t beam_cuts{0};    // times the open list was cut back to max_open / 2
+    size_t max_open{0};
+    long lower_bound{0};    // lower bound on the best total time reachable with these moves
+    bool optimal{false};    // result time equals lower_bound
+};
+
+// Admissible remaining time: every node not yet run, plus every spilled output a pending
+// consumer still needs, has to run at least once more.
+long remainingTimeLowerBound(const Problem& prob, const ScheduleState& state);
+ScheduleState astarSchedule(const Problem& prob, const AStarOptions& opts, AStarStats* stats = nullptr);
+
 struct DebugOptions {
     bool verbose{false};     // print high-level choices
     bool trace{false};       // print each expansion and ready set
@@ -26,6 +111,8 @@ struct DebugStats {
     size_t expansions{0};
     size_t prunedByMemory{0};
     size_t deadEnds{0};
+    size_t prunedBySymmetry{0};
+    size_t prunedBySleepSet{0};
 };
 
 ScheduleState scheduleWithDebug(const Problem& prob, size_t maxExpansions, double timeLimitSeconds,
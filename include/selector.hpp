@@ -0,0 +1,67 @@
+#pragma once
+
+#include "features.hpp"
+#include "priority.hpp"
+#include "schedule_cache.hpp"
+#include "scheduler.hpp"
+#include "storage.hpp"
+#include <string>
+#include <vector>
+
+// Scheduler plus its parameters, as chosen by a StrategySelector.
+struct StrategyChoice {
+    std::string scheduler{"dfs"}; // dfs | greedy | heuristic | priority | beam | dpgreedy | blocks | astar | cp | lds | restarts | tabu | remat | storage
+    size_t max_expansions{200000};
+    double time_limit{5.0};
+    size_t beam_width{32};
+    size_t lookahead{2};
+    size_t branch{8};
+    double weight{1.0}; // astar: f = g + weight * h, anytime refinement when > 1
+    size_t threads{0};  // lds, restarts, tabu: 0 = all hardware threads
+    double threshold{0.0}; // remat: output bytes per unit of recompute time, 0 = tune to the budget
+    double expansions_per_node{0.0}; // > 0: selectStrategy caps max_expansions at this times the node count
+};
+
+struct SelectorCondition {
+    int feature{GF_Nodes};
+    bool greater{true}; // feature > threshold, otherwise feature <= threshold
+    double threshold{0.0};
+};
+
+// Rules are tried in order; the first whose conditions all hold wins.
+struct SelectorRule {
+    std::vector<SelectorCondition> conditions;
+    StrategyChoice choice;
+};
+
+struct StrategySelector {
+    std::vector<SelectorRule> rules;
+};
+
+// Node-count cascade: tabu up to 1000 nodes (exact dfs finds nothing on the tight examples),
+// dfs with per-node expansion caps up to 50k, priority above that.
+StrategySelector defaultStrategySelector();
+// The first matching rule's choice, with expansions_per_node applied to the graph's node count.
+StrategyChoice selectStrategy(const StrategySelector& sel, const GraphFeatures& gf);
+
+// Rule file: one rule per line, "[<feature> <op> <value> ...] -> <scheduler> [key=value ...]",
+// with op either > or <= and '#' starting a comment. A rule with no conditions always matches.
+bool loadStrategySelector(const std::string& path, StrategySelector& out, std::string& error);
+bool saveStrategySelector(const std::string& path, const StrategySelector& sel, std::string& error);
+std::string describeStrategy(const StrategyChoice& choice);
+
+// Quality of the answer when the scheduler can prove one (astar, cp): no schedule is faster
+// than lower_bound (for cp, no schedule within its restricted move set; see cp.hpp).
+struct SearchReport {
+    long lower_bound{-1};
+    size_t expansions{0}; // states expanded (dfs, beam, lds, restarts, astar, cp) or exact decodes (tabu, remat,
+                          // storage); 0 for the one-pass schedulers
+    std::vector<StorageEvent> storage_events; // storage: transfers between the node runs
+};
+
+// With a cache, "blocks" consults it per block shape. For every other scheduler it is a
+// whole-input cache: one region keyed by blockHash(prob, 0, N) under the full budget, checked
+// before the search and never inside it, so it only answers a rerun on an isomorphic graph.
+// "storage" results are not cached: their node runs alone do not replay.
+ScheduleState runStrategy(const Problem& prob, const StrategyChoice& choice, const PriorityWeights& weights,
+                          ScheduleCache* cache = nullptr, SearchReport* report = nullptr);
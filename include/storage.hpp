@@ -0,0 +1,107 @@
+#pragma once
+
+#include "scheduler.hpp"
+#include <algorithm>
+#include <vector>
+
+// How an output is held between uses, chosen per output over a fixed first-run order (as in
+// decodeDrops). Compress and Offload need Problem::storage (applyOpRegistry); without it only
+// Keep and Recompute exist.
+//
+// Keep       resident from its run to its last use
+// Recompute  runs just before its first consumer, dropped after each use and re-run (decodeDrops)
+// Compress   runs at its slot; when the order moves past its readers the full copy is encoded once
+//            and dropped, each later use decodes it again, and the encoded copy (compressed_mem)
+//            stays on device until the last use
+// Offload    as Compress, but the copy lives in host memory: nothing stays on device and both
+//            directions cost transfer_time
+enum class StorageAction : uint8_t { Keep, Recompute, Compress, Offload };
+
+const char* storageActionName(StorageAction action);
+
+// Transfers around the node runs of a storage decode; event `step` applies before
+// execution_order[step] (step == size: after the last node).
+enum class StorageEventKind : uint8_t { Encode, Decode, Offload, Restore };
+
+struct StorageEvent {
+    uint32_t step;
+    NodeId node;
+    StorageEventKind kind;
+};
+
+struct StorageOptions {
+    size_t max_probes{24}; // decodes spent searching for the shortest prefix that fits
+};
+
+struct StorageStats {
+    size_t recomputed{0};
+    size_t compressed{0};
+    size_t offloaded{0};
+    size_t encodes{0};
+    size_t decodes{0};
+    size_t transfers{0};
+    size_t probes{0};
+    bool fits{false};
+};
+
+// One output's cheapest alternative to Keep, as time per byte it frees between uses
+struct StorageOption {
+    double cost;
+    NodeId node;
+    StorageAction action;
+    bool operator<(const StorageOption& o) const { return cost != o.cost ? cost < o.cost : node < o.node; }
+};
+
+// Options for every output with consumers, cheapest first. Recompute is always available;
+// Offload costs `migrate_per_byte` per byte and direction when that is >= 0, otherwise the
+// output's transfer_time if `storage_costs`; Compress needs `storage_costs`. Outputs whose best
+// option is Compress still hold their encoded copies once relieved, so they appear again at the
+// tail with the cheapest option that frees the device entirely.
+std::vector<StorageOption> rankStorageOptions(const Problem& prob, double migrate_per_byte, bool storage_costs);
+
+// Plan with the first `k` ranked options applied, Keep elsewhere.
+std::vector<StorageAction> storagePrefixPlan(const Problem& prob, const std::vector<StorageOption>& ranked, size_t k);
+
+// Binary search over prefix lengths k in [0, n] for the shortest whose decode fits
+// total_memory: later entries cost more time per byte. Until one fits, the lowest complete peak
+// is kept. `decode(k)` returns a result, `stateOf(result)` its ScheduleState. Spends at most
+// max(2, max_probes) decodes, counted in `probes`; `best_k` receives the prefix returned.
+template <class Decode, class StateOf>
+auto searchStoragePrefix(const Problem& prob, size_t n, size_t max_probes, size_t& probes, Decode&& decode,
+                         StateOf&& stateOf, size_t* best_k = nullptr) -> decltype(decode(size_t{0})) {
+    auto complete = [&](const ScheduleState& s) { return s.computed.count() == prob.size(); };
+    auto fits = [&](const ScheduleState& s) { return complete(s) && s.memory_peak <= prob.total_memory; };
+    const size_t end = probes + std::max<size_t>(2, max_probes);
+    auto best = decode(size_t{0});
+    ++probes;
+    size_t bestK = 0;
+    size_t lo = 1, hi = fits(stateOf(best)) ? 0 : n;
+    while (lo <= hi && probes < end) {
+        size_t mid = lo + (hi - lo) / 2;
+        auto r = decode(mid);
+        ++probes;
+        const ScheduleState& s = stateOf(r);
+        const ScheduleState& b = stateOf(best);
+        bool ok = fits(s);
+        bool better = ok || (!fits(b) && complete(s) && (!complete(b) || s.memory_peak < b.memory_peak));
+        if (better) { best = std::move(r); bestK = mid; }
+        if (ok) hi = mid - 1; else lo = mid + 1;
+    }
+    if (best_k) *best_k = bestK;
+    return best;
+}
+
+// Decodes `order` with one action per output (Keep where `plan` is shorter). Transitions are
+// charged in total_time and encoded copies in current_memory; execution_order lists node runs
+// only and `events` receives the transitions between them, so replaySchedule cannot reproduce
+// the result on its own. Returns an incomplete state if a recompute cascade cannot be resolved.
+ScheduleState decodeStoragePlan(const Problem& prob, const std::vector<NodeId>& order,
+                                const std::vector<StorageAction>& plan, StorageStats* stats = nullptr,
+                                std::vector<StorageEvent>* events = nullptr);
+
+// searchStoragePrefix over rankStorageOptions with the outputs' own storage costs, like
+// eagerRematSchedule over the ratio ranking. Returns the best decode found; `plan` receives its
+// actions and `events` its transitions.
+ScheduleState storageSchedule(const Problem& prob, const ScheduleState& seed, const StorageOptions& opts,
+                              StorageStats* stats = nullptr, std::vector<StorageAction>* plan = nullptr,
+                              std::vector<StorageEvent>* events = nullptr);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+// Out-of-core scheduler for examples-format files too large to load as a Problem.
+// Rows must appear in increasing id order with inputs referring to earlier ids, which is
+// how the traced graphs are written. Pass 1 counts consumers per id into sorted run files
+// next to the output, which are then merged `merge_fan_in` at a time until that many remain;
+// pass 2 merges the rest while re-reading the rows, keeps a window of
+// pending rows plus the live outputs, and greedily pulls memory-freeing rows forward
+// within the window (otherwise file order is kept). When a row would exceed the budget, least
+// recently used outputs are evicted (ones no pending row reads first) and recomputed when read
+// again, together with any read-out inputs; the last `history` read-out rows are kept for that,
+// plus the ones evicted outputs still need. Each step is appended to the order file as it is
+// chosen, recomputations marked with a trailing '*', so memory depends on the window, the live
+// frontier and `history`, not on N.
+struct StreamOptions {
+    size_t window{64};          // pending rows the greedy choice may reorder
+    size_t run_edges{1u << 20}; // edges buffered before a sorted run is written in pass 1
+    size_t merge_fan_in{16};    // runs open at once while merging
+    size_t history{1u << 16};   // read-out rows kept so evicted outputs can be recomputed deeper
+};
+
+struct StreamStats {
+    size_t nodes{0};
+    size_t runs{0};             // written by pass 1
+    size_t merge_passes{0};
+    size_t max_resident{0};
+    size_t evictions{0};
+    size_t recomputes{0};
+    long total_memory{0};
+    long total_time{0};
+    long memory_peak{0};
+};
+
+// Writes one node name per line to `order_path`. Eviction can run out of candidates (pinned,
+// or needing a row that was already dropped), so the schedule can still exceed the budget;
+// callers compare stats.memory_peak with stats.total_memory.
+bool streamSchedule(const std::string& input_path, const std::string& order_path,
+                    const StreamOptions& opts, StreamStats& stats, std::string& error);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "parser.hpp"
+#include <vector>
+
+// Random training-graph-like DAGs for benchmarking and selector training.
+struct SynthOptions {
+    size_t nodes{1000};
+    unsigned seed{1};
+    size_t max_fan_in{3};
+    size_t locality{64};       // inputs are drawn from the previous `locality` nodes
+    double chain_prob{0.5};    // probability a node consumes only its immediate predecessor
+    double budget_factor{0.8}; // total_memory = budget_factor * peak of the id-order sweep
+};
+
+// Ids are already topological and names follow parseExamplesFormat ("<Op>-op0_id<i>").
+std::vector<ParsedNodeSpec> generateSyntheticGraph(const SynthOptions& opts, long& total_memory);
+// Same graph built directly in CSR form; used for the multi-million-node memory checks.
+Problem generateSyntheticProblem(const SynthOptions& opts);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "scheduler.hpp"
+
+// Local search over keep/recompute decisions for a fixed first-run order. The drop set D holds
+// the outputs that are not kept between uses: a node in D runs just before its first consumer
+// (not at its place in the order) and is dropped after each use, so every later consumer pays
+// for a recomputation. Everything else stays resident from its run to its last use.
+//
+// Each move flips one node in or out of D. The neighborhood is screened with an incremental
+// peak evaluator: the step memory profile of the current schedule sits in a max segment tree,
+// and a flip is scored by the range adds it implies (the output's residency, the extended or
+// recomputed inputs, the new run steps) without decoding. The best screened flips are then
+// decoded exactly in parallel and the best non-tabu one is taken. While the schedule is over
+// budget, drops are first chained on the evaluator (each relieving the currently highest step)
+// and decoded together; the chain length halves whenever the decode disagrees.
+struct TabuOptions {
+    size_t max_iterations{1000};
+    double time_limit{5.0};
+    size_t tenure{10};         // iterations a flipped node stays tabu
+    size_t neighborhood{32};   // flips screened per evaluator step
+    size_t exact{4};           // best screened flips decoded per iteration
+    size_t batch{256};         // over budget: drops chained on the evaluator per decode
+    size_t threads{0};         // 0 = defaultThreadCount()
+};
+
+struct TabuStats {
+    size_t iterations{0};
+    size_t screened{0};
+    size_t decodes{0};
+    size_t approximate{0};     // screened flips whose estimate skipped recompute cascades
+    size_t improvements{0};
+    size_t dropped{0};         // |D| of the returned schedule
+    long start_peak{0};
+    long start_time{0};
+};
+
+// First runs of `seed` in order, completed topologically if it is partial.
+std::vector<NodeId> firstRunOrder(const Problem& prob, const ScheduleState& seed);
+
+// Fast list-scheduler decode: runs `order` (a topological first-run order) with the outputs in
+// `drop` rematerialized on demand, recomputing dropped inputs recursively. Returns an
+// incomplete state if a recompute cascade cannot be resolved.
+ScheduleState decodeDrops(const Problem& prob, const std::vector<NodeId>& order, const NodeBitset& drop);
+
+// Starts from firstRunOrder(seed) with D empty.
+// Minimizes memory above total_memory first, then total time; returns the best decode, which
+// may still exceed the budget when no feasible drop set was found.
+ScheduleState tabuSchedule(const Problem& prob, const ScheduleState& seed, const TabuOptions& opts,
+                           TabuStats* stats = nullptr);
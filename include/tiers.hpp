@@ -0,0 +1,80 @@
+#pragma once
+
+#include "storage.hpp"
+#include <string>
+#include <vector>
+
+// Memory hierarchy: nodes run in the fast tier (tier 0, whose capacity is Problem::total_memory)
+// and outputs may wait in slower tiers between uses. Described in a text file, fastest first:
+//
+//     # name  capacity  bandwidth
+//     hbm     -         0            # '-' keeps the input file's budget
+//     dram    68719476736  16384     # bytes, bytes per time unit in either direction
+//     nvme    1099511627776  2048
+struct MemoryTier {
+    std::string name;
+    long capacity{-1};
+    double bandwidth{0.0};
+};
+
+struct TierConfig {
+    std::vector<MemoryTier> tiers;
+};
+
+bool loadTierConfig(const std::string& path, TierConfig& out, std::string& error);
+// Sets total_memory from tier 0's capacity unless it is '-'.
+void applyTierConfig(const TierConfig& tiers, Problem& prob);
+// Time to move `bytes` between the fast tier and `tier`, rounded up.
+long tierTransferTime(const MemoryTier& tier, long bytes);
+
+// Demote: copies the fast-tier output down to `tier` and drops it from the fast tier; the copy
+// stays until the output's last consumer has run. Promote: copies it back from `tier`. Drop:
+// discards the fast-tier copy (recomputed, or promoted again, when needed). Moves with `step` i
+// apply before execution_order[i] (i == size: after the last node).
+enum class TierMoveKind : uint8_t { Demote, Promote, Drop };
+
+struct TierMove {
+    uint32_t step;
+    NodeId node;
+    TierMoveKind kind;
+    uint8_t tier;
+};
+
+struct TieredSchedule {
+    ScheduleState state;          // total_time includes migrations; memory_peak is the fast tier's
+    std::vector<TierMove> moves;  // in step order
+    std::vector<long> tier_peak;  // per tier; [0] == state.memory_peak
+};
+
+struct TierOptions {
+    size_t max_probes{24}; // searchStoragePrefix budget, halved per policy with several lower tiers
+};
+
+struct TierStats {
+    size_t demotions{0};
+    size_t promotions{0};
+    size_t recomputes{0};
+    size_t probes{0};
+    long migration_time{0};
+    bool fits{false};
+};
+
+// Decodes `order` like decodeStoragePlan, with Offload meaning "migrate": the output is demoted
+// to the fastest lower tier with room when the order moves past its readers, and is dropped
+// (recomputed when needed) when none has. Without `slow`, tiers whose round trips cost more than
+// recomputing the output are skipped too. Compress is treated as Keep.
+TieredSchedule decodeTierPlan(const Problem& prob, const TierConfig& tiers, const std::vector<NodeId>& order,
+                              const std::vector<StorageAction>& plan, bool slow = true, TierStats* stats = nullptr);
+
+// Per output, migration through the fastest lower tier or recomputation, whichever costs less
+// time per byte (rankStorageOptions); the shortest prefix of that ranking whose decode fits the
+// fast tier (searchStoragePrefix). With several lower tiers, decodes with and without `slow`
+// are searched and the faster fitting result wins.
+TieredSchedule tieredSchedule(const Problem& prob, const TierConfig& tiers, const ScheduleState& seed,
+                              const TierOptions& opts, TierStats* stats = nullptr);
+
+// Replays `sched` from scratch: every input must be in the fast tier when its consumer runs,
+// moves must find the output where they expect it, and no tier may exceed its capacity.
+// Recomputes total_time and the per-tier peaks into `replayed`.
+bool validateTieredSchedule(const Problem& prob, const TierConfig& tiers, const TieredSchedule& sched,
+                            std::string& error, TieredSchedule* replayed = nullptr);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "model.hpp"
+#include <atomic>
+#include <vector>
+
+// 64-bit identity of a search state: computed and resident sets (current memory follows from
+// the resident set). Never 0, which marks an empty table slot.
+uint64_t stateKey(const ScheduleState& state);
+
+// Closed list for best-first searches: a direct-mapped table of states already reached and the
+// best (time, peak) seen for each. A colliding key overwrites its slot, so memory stays fixed
+// and losing an entry only costs a repeated expansion, never a wrong answer.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t entries); // rounded up to a power of two
+
+    // True when `key` was already reached with time <= g and peak <= peak. `budget` is the search
+    // left below the state when it was stored (lds: remaining discrepancies); an entry only
+    // dominates requests with no larger budget.
+    bool dominated(uint64_t key, long g, long peak, size_t budget = 0) const;
+    void store(uint64_t key, long g, long peak, size_t budget = 0);
+
+    size_t capacity() const { return slots_.size(); }
+    size_t bytesUsed() const { return slots_.size() * sizeof(Entry); }
+
+private:
+    struct Entry {
+        uint64_t key{0};
+        long g{0};
+        long peak{0};
+        size_t budget{0};
+    };
+    HugeVector<Entry> slots_;
+    uint64_t mask_{0};
+};
+
+// TranspositionTable's contract for tables shared by several threads, without locks. Each slot
+// is three relaxed atomics (check, g, peak) with check = key ^ g ^ mix(peak), as in the lockless
+// hashing of chess engines: a reader that sees halves of two concurrent writes fails the check
+// and treats the slot as empty, so a race costs a repeated expansion, never a wrong answer. Keys
+// probe kProbe consecutive slots (open addressing); a new key takes the first empty slot or
+// evicts the one holding the largest g.
+class ConcurrentTranspositionTable {
+public:
+    static constexpr size_t kProbe = 4;
+
+    explicit ConcurrentTranspositionTable(size_t entries); // rounded up to a power of two, at least kProbe
+
+    bool dominated(uint64_t key, long g, long peak) const;
+    void store(uint64_t key, long g, long peak);
+    void clear();
+
+    size_t capacity() const { return mask_ + 1; }
+    size_t bytesUsed() const { return capacity() * sizeof(Entry); }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> g{0};
+        std::atomic<uint64_t> peak{0};
+    };
+    HugeVector<Entry> slots_; // sized once; atomics never move
+    uint64_t mask_{0};
+};
@@ -26,35 +26,32 @@ int main(int argc, char** argv) {
     Problem prob = buildProblem(total_memory, specs);
 
     // Kahn's algorithm for a simple topological order
-    std::unordered_map<std::string, int> indeg;
-    for (const auto& kv : prob.nodes) indeg[kv.first] = 0;
-    for (const auto& kv : prob.nodes) {
-        for (const auto& in : kv.second.getInputs()) indeg[kv.first]++;
-    }
-    std::queue<std::string> q;
-    for (const auto& kv : indeg) if (kv.second == 0) q.push(kv.first);
+    std::vector<int> indeg(prob.size());
+    for (NodeId id = 0; id < prob.size(); ++id) indeg[id] = static_cast<int>(prob.inputs(id).size());
+    std::queue<NodeId> q;
+    for (NodeId id = 0; id < prob.size(); ++id) if (indeg[id] == 0) q.push(id);
 
-    std::vector<std::string> order;
-    order.reserve(prob.nodes.size());
+    std::vector<NodeId> order;
+    order.reserve(prob.size());
     long total_time = 0;
     long memory_peak = 0;
     long current_memory = 0;
 
     while (!q.empty()) {
-        std::string u = q.front(); q.pop();
+        NodeId u = q.front(); q.pop();
         order.push_back(u);
-        const Node& n = prob.nodes.at(u);
+        const Node& n = prob.nodes[u];
         total_time += n.getTimeCost();
         // naive memory accounting ignoring ceiling: add output, don't free inputs
         current_memory += n.getOutputMem();
         if (current_memory > memory_peak) memory_peak = current_memory;
 
-        for (const auto& v : prob.successors[u]) {
+        for (NodeId v : prob.consumers(u)) {
             if (--indeg[v] == 0) q.push(v);
         }
     }
 
-    if (order.size() != prob.nodes.size()) {
+    if (order.size() != prob.size()) {
         std::cerr << "Graph has cycles or missing sources; cannot produce baseline.\n";
         return 3;
     }
@@ -62,7 +59,7 @@ int main(int argc, char** argv) {
     std::cout << "Baseline schedule (topological):\n";
     for (size_t i = 0; i < order.size(); ++i) {
         if (i) std::cout << " -> ";
-        std::cout << order[i];
+        std::cout << prob.name(order[i]);
     }
     std::cout << "\nTotal time: " << total_time << "\n";
     std::cout << "Naive memory peak (no freeing): " << memory_peak << "\n";
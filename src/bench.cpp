@@ -0,0 +1,473 @@
+#include "bounds.hpp"
+#include "numa.hpp"
+#include "online.hpp"
+#include "parser.hpp"
+#include "perf_counters.hpp"
+#include "selector.hpp"
+#include "synth.hpp"
+#include "transposition.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// Benchmark suite: runs every candidate strategy over the given inputs plus synthetic graphs,
+// prints one row per run and optionally fits a small decision tree mapping graph features to
+// the best strategy, written as a selector rule file for `scheduler --selector`.
+
+struct BenchOptions {
+    std::vector<std::string> inputs;
+    size_t synthetic_count{0};
+    size_t synthetic_nodes{200};
+    unsigned seed{1};
+    double penalty_seconds{10.0}; // runs slower than this count as failures when training
+    size_t depth{2};
+    std::string weights;
+    std::string train_output;
+    std::string memory_check;    // graph file to load under the RSS cap instead
+    double rss_cap_mb{0.0};
+    std::string write_synthetic; // writes a synthetic_nodes graph to this file instead
+    size_t online_lookahead{0}; // > 0: also stream each case through OnlineScheduler
+    size_t table_entries{0};    // > 0: transposition table contention benchmark instead
+    size_t table_ops{1000000};  // probe + store pairs per thread
+    size_t numa_passes{0};      // > 0: NUMA placement benchmark over the inputs instead
+    bool perf{false};           // hardware counters per expansion on every strategy row
+};
+
+struct BenchCase {
+    std::string label;
+    Problem prob;
+    GraphFeatures features;
+    std::vector<double> cost; // per candidate strategy
+};
+
+static std::vector<StrategyChoice> candidateStrategies() {
+    std::vector<StrategyChoice> out;
+    auto add = [&](const std::string& name, size_t maxExpansions, double timeLimit) {
+        StrategyChoice c; c.scheduler = name; c.max_expansions = maxExpansions; c.time_limit = timeLimit;
+        out.push_back(c);
+        return &out.back();
+    };
+    add("greedy", 0, 0);
+    add("heuristic", 0, 0);
+    add("priority", 0, 0);
+    add("dfs", 2000, 0.2);
+    add("dfs", 200000, 1.0);
+    add("beam", 20000, 0)->beam_width = 8;
+    add("beam", 200000, 0)->beam_width = 32;
+    add("dpgreedy", 0, 0);
+    add("blocks", 200000, 1.0);
+    add("astar", 200000, 1.0);
+    add("astar", 200000, 1.0)->weight = 2.0;
+    add("cp", 200000, 1.0);
+    add("lds", 200000, 1.0);
+    add("restarts", 200000, 1.0);
+    add("tabu", 200000, 1.0);
+    add("remat", 0, 0);
+    add("storage", 0, 0);
+    return out;
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string a = argv[i];
+            auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+            const char* v = nullptr;
+            if (a == "--synthetic" && (v = value())) opts.synthetic_count = std::stoul(v);
+            else if (a == "--synthetic-nodes" && (v = value())) opts.synthetic_nodes = std::stoul(v);
+            else if (a == "--seed" && (v = value())) opts.seed = static_cast<unsigned>(std::stoul(v));
+            else if (a == "--penalty-seconds" && (v = value())) opts.penalty_seconds = std::stod(v);
+            else if (a == "--depth" && (v = value())) opts.depth = std::stoul(v);
+            else if (a == "--weights" && (v = value())) opts.weights = v;
+            else if (a == "--train-selector" && (v = value())) opts.train_output = v;
+            else if (a == "--memory-check" && (v = value())) opts.memory_check = v;
+            else if (a == "--write-synthetic" && (v = value())) opts.write_synthetic = v;
+            else if (a == "--rss-cap-mb" && (v = value())) opts.rss_cap_mb = std::stod(v);
+            else if (a == "--online" && (v = value())) opts.online_lookahead = std::stoul(v);
+            else if (a == "--table-scaling" && (v = value())) opts.table_entries = std::stoul(v);
+            else if (a == "--table-ops" && (v = value())) opts.table_ops = std::stoul(v);
+            else if (a == "--numa-scaling" && (v = value())) opts.numa_passes = std::stoul(v);
+            else if (a == "--perf") opts.perf = true;
+            else if (a == "--huge-pages" && (v = value())) {
+                HugePageMode mode;
+                if (!parseHugePageMode(v, mode)) return false;
+                setHugePageMode(mode);
+            }
+            else if (!a.empty() && a[0] == '-') return false;
+            else opts.inputs.push_back(a);
+        }
+    } catch (const std::exception&) {
+        return false; // malformed number
+    }
+    return !opts.inputs.empty() || opts.synthetic_count > 0 || !opts.memory_check.empty() ||
+           !opts.write_synthetic.empty() || opts.table_entries > 0;
+}
+
+// Counter columns of a strategy row, normalised by `units` (expansions or decodes, or scheduled
+// steps for the one-pass schedulers); "-" for events the kernel refused and for runs with no units.
+static void printPerfColumns(const PerfSample& ps, size_t units, const char* unitName) {
+    const double u = static_cast<double>(units);
+    auto perUnit = [&](int e) {
+        if (ps.valid[e] && units > 0) std::cout << std::setw(12) << std::fixed << std::setprecision(1) << ps.value[e] / u;
+        else std::cout << std::setw(12) << "-";
+    };
+    std::cout << std::setw(8) << unitName << std::setw(10) << units;
+    perUnit(PE_Cycles);
+    perUnit(PE_Instructions);
+    if (ps.valid[PE_Cycles] && ps.valid[PE_Instructions] && ps.value[PE_Cycles] > 0)
+        std::cout << std::setw(8) << std::setprecision(2) << ps.value[PE_Instructions] / ps.value[PE_Cycles];
+    else std::cout << std::setw(8) << "-";
+    perUnit(PE_L1dMisses);
+    perUnit(PE_LlcMisses);
+    perUnit(PE_BranchMisses);
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+// Peak resident set size of this process in MiB (VmHWM), or -1 where /proc is unavailable.
+static double peakRssMb() {
+    std::ifstream in("/proc/self/status");
+    std::string key;
+    while (in >> key) {
+        if (key == "VmHWM:") { double kb = 0; in >> kb; return kb / 1024.0; }
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return -1.0;
+}
+
+// Loads a graph file through the real parser, runs the feature pass over it and fails
+// (exit 4) if peak RSS exceeds the cap; guards the memory-lean representation. The memory_check
+// test runs it on a 10M-node graph written by --write-synthetic.
+static int runMemoryCheck(const BenchOptions& opts) {
+    auto t0 = std::chrono::steady_clock::now();
+    Problem prob;
+    std::string error;
+    if (!loadProblemFile(opts.memory_check, prob, error)) {
+        std::cerr << "Parse error in " << opts.memory_check << ": " << error << "\n";
+        return 2;
+    }
+    GraphFeatures features = computeGraphFeatures(prob);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double rss = peakRssMb();
+    std::cout << "nodes=" << prob.size() << " edges=" << static_cast<size_t>(features.v[GF_Edges])
+              << " graph_bytes=" << prob.bytesUsed()
+              << " bytes_per_node=" << std::setprecision(4) << static_cast<double>(prob.bytesUsed()) / std::max<size_t>(prob.size(), 1)
+              << " peak_rss_mb=" << rss << " wall_ms=" << static_cast<long>(wall * 1000) << "\n";
+    if (opts.rss_cap_mb > 0 && rss > opts.rss_cap_mb) {
+        std::cerr << "peak RSS " << rss << " MiB exceeds cap " << opts.rss_cap_mb << " MiB\n";
+        return 4;
+    }
+    return 0;
+}
+
+static int writeSynthetic(const BenchOptions& opts) {
+    SynthOptions so;
+    so.nodes = opts.synthetic_nodes;
+    so.seed = opts.seed;
+    std::string error;
+    if (!saveExamplesProblem(opts.write_synthetic, generateSyntheticProblem(so), error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Shared closed-list throughput at 1..64 threads: every thread probes and then stores keys drawn
+// from one pool twice the table's size, so threads keep hitting each other's slots. The lock-free
+// table is compared with TranspositionTable behind a mutex.
+static int runTableScaling(const BenchOptions& opts) {
+    const uint64_t pool = 2 * opts.table_entries;
+    auto splitmix = [](uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    };
+    // Deterministic per key, so any thread storing a key writes the same record
+    auto keyOf = [](uint64_t i) { return (i + 1) * 0x9e3779b97f4a7c15ull | 1; };
+    auto gOf = [](uint64_t key) { return static_cast<long>(key >> 40); };
+    auto peakOf = [](uint64_t key) { return static_cast<long>(key & 0xFFFFFF); };
+    auto measure = [&](size_t threads, auto&& probe, auto&& store, size_t& hits) {
+        std::vector<size_t> hit(threads, 0);
+        std::vector<std::thread> pool_threads;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t) {
+            pool_threads.emplace_back([&, t] {
+                uint64_t rng = opts.seed * 0x2545f4914f6cdd1dull + t;
+                for (size_t i = 0; i < opts.table_ops; ++i) {
+                    uint64_t key = keyOf(splitmix(rng) % pool);
+                    if (probe(key, gOf(key), peakOf(key))) ++hit[t];
+                    else store(key, gOf(key), peakOf(key));
+                }
+            });
+        }
+        for (auto& th : pool_threads) th.join();
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        hits = 0;
+        for (size_t h : hit) hits += h;
+        return wall;
+    };
+    std::cout << "entries=" << opts.table_entries << " ops_per_thread=" << opts.table_ops
+              << " hardware_threads=" << std::thread::hardware_concurrency() << "\n";
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "lockfree_mops" << std::setw(12) << "hit_rate"
+              << std::setw(16) << "mutex_mops" << std::setw(12) << "hit_rate" << std::setw(10) << "speedup" << "\n";
+    double base = 0.0;
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        ConcurrentTranspositionTable shared(opts.table_entries);
+        size_t lfHits = 0;
+        double lf = measure(threads, [&](uint64_t k, long g, long p) { return shared.dominated(k, g, p); },
+                            [&](uint64_t k, long g, long p) { shared.store(k, g, p); }, lfHits);
+        TranspositionTable locked(opts.table_entries);
+        std::mutex mu;
+        size_t muHits = 0;
+        double mx = measure(threads, [&](uint64_t k, long g, long p) { std::lock_guard<std::mutex> l(mu); return locked.dominated(k, g, p); },
+                            [&](uint64_t k, long g, long p) { std::lock_guard<std::mutex> l(mu); locked.store(k, g, p); }, muHits);
+        const double ops = static_cast<double>(threads * opts.table_ops);
+        double lfRate = ops / lf / 1e6, muRate = ops / mx / 1e6;
+        if (threads == 1) base = lfRate;
+        std::cout << std::setw(8) << threads << std::setw(16) << std::setprecision(4) << lfRate
+                  << std::setw(12) << static_cast<double>(lfHits) / ops << std::setw(16) << muRate
+                  << std::setw(12) << static_cast<double>(muHits) / ops << std::setw(10) << lfRate / base << "\n";
+    }
+    return 0;
+}
+
+// Graph-bound throughput at 1..64 threads: every worker repeats computeScheduleBounds (a pass
+// over all node and edge columns) `passes` times, either unpinned on the one loaded graph or
+// pinned per NUMA node on that node's replica. On a single-node host both columns match.
+static int runNumaScaling(const BenchOptions& opts, const Problem& prob, const std::string& label) {
+    NumaTopology topo = detectNumaTopology();
+    size_t cpus = 0;
+    for (const auto& c : topo.node_cpus) cpus += c.size();
+    if (cpus == 0) cpus = std::max(1u, std::thread::hardware_concurrency());
+    auto t0 = std::chrono::steady_clock::now();
+    ProblemReplicas replicas(prob, topo);
+    double replicate = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << label << ": nodes=" << topo.nodes() << " cpus=" << cpus << " graph_bytes=" << prob.bytesUsed()
+              << " replicate_ms=" << static_cast<long>(replicate * 1000) << "\n";
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "shared_pps" << std::setw(16) << "numa_pps"
+              << std::setw(10) << "gain" << "\n";
+    NumaTopology flat; // one node, no pinning
+    flat.node_cpus.emplace_back();
+    std::atomic<long> sink{0};
+    auto measure = [&](size_t threads, const NumaTopology& t, const ProblemReplicas& reps) {
+        auto start = std::chrono::steady_clock::now();
+        numaParallelFor(threads, threads, t, [&](size_t, size_t, size_t node) {
+            const Problem& local = reps.local(node);
+            for (size_t k = 0; k < opts.numa_passes; ++k) sink += computeScheduleBounds(local).time;
+        });
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(threads * opts.numa_passes) / wall;
+    };
+    ProblemReplicas shared(prob, flat);
+    measure(1, flat, shared); // warm-up: page faults and cache fill
+    for (size_t threads = 1; threads <= std::min<size_t>(64, 2 * cpus); threads *= 2) {
+        double flatRate = measure(threads, flat, shared);
+        double numaRate = measure(threads, topo, replicas);
+        std::cout << std::setw(8) << threads << std::setw(16) << std::setprecision(4) << flatRate
+                  << std::setw(16) << numaRate << std::setw(10) << numaRate / flatRate << "\n";
+    }
+    return sink.load() == -1 ? 1 : 0;
+}
+
+// Feeds `prob` node by node to an OnlineScheduler, as an eager runtime would see it
+static OnlineStats runOnline(const Problem& prob, size_t lookahead) {
+    OnlineOptions oo;
+    oo.lookahead = lookahead;
+    OnlineScheduler online(prob.total_memory, oo);
+    ParsedNodeSpec spec;
+    std::string error;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        const Node& n = prob.nodes[id];
+        spec.name = prob.name(id);
+        spec.run_mem = n.getRunMem();
+        spec.output_mem = n.getOutputMem();
+        spec.time_cost = n.getTimeCost();
+        spec.inputs.clear();
+        for (NodeId x : prob.inputs(id)) spec.inputs.push_back(prob.name(x));
+        if (!online.push(spec, error)) { std::cerr << error << "\n"; break; }
+    }
+    online.finish();
+    return online.stats();
+}
+
+// Summed cost over `idx` when every case uses the single best candidate; returns that candidate.
+static size_t bestCandidate(const std::vector<BenchCase>& cases, const std::vector<size_t>& idx, double& total) {
+    size_t nc = cases.empty() ? 0 : cases.front().cost.size();
+    size_t best = 0; total = std::numeric_limits<double>::infinity();
+    for (size_t s = 0; s < nc; ++s) {
+        double sum = 0.0;
+        for (size_t i : idx) sum += cases[i].cost[s];
+        if (sum < total) { total = sum; best = s; }
+    }
+    return best;
+}
+
+static void growTree(const std::vector<BenchCase>& cases, const std::vector<size_t>& idx, size_t depth,
+                     std::vector<SelectorCondition>& path, const std::vector<StrategyChoice>& cands,
+                     StrategySelector& out) {
+    double leafCost = 0.0;
+    size_t leaf = bestCandidate(cases, idx, leafCost);
+    int bestFeature = -1; double bestThreshold = 0.0, bestSplit = leafCost - 1e-9;
+    if (depth > 0 && idx.size() > 1) {
+        for (int f = 0; f < GF_Count; ++f) {
+            std::vector<double> vals;
+            for (size_t i : idx) vals.push_back(cases[i].features.v[f]);
+            std::sort(vals.begin(), vals.end());
+            vals.erase(std::unique(vals.begin(), vals.end()), vals.end());
+            for (size_t k = 0; k + 1 < vals.size(); ++k) {
+                double t = 0.5 * (vals[k] + vals[k + 1]);
+                std::vector<size_t> lo, hi;
+                for (size_t i : idx) (cases[i].features.v[f] <= t ? lo : hi).push_back(i);
+                double cl = 0.0, ch = 0.0;
+                bestCandidate(cases, lo, cl); bestCandidate(cases, hi, ch);
+                if (cl + ch < bestSplit) { bestSplit = cl + ch; bestFeature = f; bestThreshold = t; }
+            }
+        }
+    }
+    if (bestFeature < 0) {
+        SelectorRule rule; rule.conditions = path; rule.choice = cands[leaf];
+        out.rules.push_back(std::move(rule));
+        return;
+    }
+    std::vector<size_t> lo, hi;
+    for (size_t i : idx) (cases[i].features.v[bestFeature] <= bestThreshold ? lo : hi).push_back(i);
+    path.push_back({bestFeature, false, bestThreshold});
+    growTree(cases, lo, depth - 1, path, cands, out);
+    path.back().greater = true;
+    growTree(cases, hi, depth - 1, path, cands, out);
+    path.pop_back();
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::cout << "Usage: bench [--synthetic K] [--synthetic-nodes N] [--seed S] [--penalty-seconds X] "
+                     "[--weights weights.txt] [--train-selector out.txt] [--depth D] [--online L] "
+                     "[--huge-pages off|thp|explicit] [--perf] [input_file...]\n"
+                     "       bench --write-synthetic out.txt [--synthetic-nodes N] [--seed S]\n"
+                     "       bench --memory-check graph.txt [--rss-cap-mb M]\n"
+                     "       bench --table-scaling ENTRIES [--table-ops N] [--seed S]\n"
+                     "       bench --numa-scaling PASSES input_file...\n";
+        return 0;
+    }
+    if (!opts.write_synthetic.empty()) return writeSynthetic(opts);
+    if (!opts.memory_check.empty()) return runMemoryCheck(opts);
+    if (opts.table_entries > 0) return runTableScaling(opts);
+    PriorityWeights weights = defaultPriorityWeights();
+    if (!opts.weights.empty()) {
+        std::string error;
+        if (!loadPriorityWeights(opts.weights, weights, error)) { std::cerr << error << "\n"; return 1; }
+    }
+
+    std::vector<BenchCase> cases;
+    for (const auto& path : opts.inputs) {
+        BenchCase bc; bc.label = path;
+        std::string error;
+        if (!loadProblemFile(path, bc.prob, error)) {
+            std::cerr << "Parse error in " << path << ": " << error << "\n";
+            return 2;
+        }
+        if (opts.numa_passes > 0) {
+            runNumaScaling(opts, bc.prob, path);
+            continue;
+        }
+        cases.push_back(std::move(bc));
+    }
+    if (opts.numa_passes > 0) return 0;
+    static const double kBudgetFactors[] = {0.5, 0.7, 0.9, 1.1};
+    for (size_t k = 0; k < opts.synthetic_count; ++k) {
+        SynthOptions so;
+        so.nodes = opts.synthetic_nodes;
+        so.seed = opts.seed + static_cast<unsigned>(k);
+        so.budget_factor = kBudgetFactors[k % 4];
+        so.chain_prob = (k / 4) % 2 ? 0.8 : 0.3;
+        BenchCase bc;
+        bc.label = "synthetic#" + std::to_string(k);
+        bc.prob = generateSyntheticProblem(so);
+        cases.push_back(std::move(bc));
+    }
+
+    if (hugePageMode() != HugePageMode::Off) {
+        HugePageStats hp = hugePageStats();
+        std::cout << "huge pages (" << hugePageModeName(hugePageMode()) << "): explicit=" << hp.explicit_bytes
+                  << " transparent=" << hp.transparent_bytes << " plain=" << hp.plain_bytes << " fallbacks=" << hp.fallbacks << "\n";
+    }
+    std::unique_ptr<PerfCounters> counters;
+    if (opts.perf) {
+        counters.reset(new PerfCounters());
+        if (!counters->error().empty())
+            std::cout << "perf counters " << (counters->available() ? "partly" : "not") << " available (" << counters->error() << ")\n";
+    }
+    auto cands = candidateStrategies();
+    std::cout << std::left << std::setw(28) << "input" << std::setw(44) << "strategy"
+              << std::right << std::setw(10) << "time" << std::setw(14) << "peak"
+              << std::setw(10) << "cost" << std::setw(10) << "wall_ms";
+    if (counters) {
+        std::cout << std::setw(8) << "unit" << std::setw(10) << "units" << std::setw(12) << "cycles/u" << std::setw(12) << "instr/u"
+                  << std::setw(8) << "ipc" << std::setw(12) << "l1d_miss/u" << std::setw(12) << "llc_miss/u" << std::setw(12) << "br_miss/u";
+    }
+    std::cout << "\n";
+    for (auto& bc : cases) {
+        bc.features = computeGraphFeatures(bc.prob);
+        long bestOffline = -1; // fastest complete schedule within budget
+        for (const auto& c : cands) {
+            SearchReport report;
+            if (counters) counters->start();
+            auto t0 = std::chrono::steady_clock::now();
+            ScheduleState s = runStrategy(bc.prob, c, weights, nullptr, &report);
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            PerfSample ps;
+            if (counters) ps = counters->stop();
+            double cost = relativeScheduleCost(bc.prob, s);
+            if (wall > opts.penalty_seconds) cost += 10.0;
+            bc.cost.push_back(cost);
+            bool complete = s.computed.count() == bc.prob.size();
+            if (complete && s.memory_peak <= bc.prob.total_memory && (bestOffline < 0 || s.total_time < bestOffline)) bestOffline = s.total_time;
+            std::cout << std::left << std::setw(28) << bc.label << std::setw(44) << describeStrategy(c)
+                      << std::right << std::setw(10) << (complete ? std::to_string(s.total_time) : "-")
+                      << std::setw(14) << s.memory_peak << std::setw(10) << std::setprecision(4) << cost
+                      << std::setw(10) << static_cast<long>(wall * 1000);
+            if (counters) {
+                if (report.expansions > 0) printPerfColumns(ps, report.expansions, "exp");
+                else printPerfColumns(ps, s.execution_order.size(), "step");
+            }
+            std::cout << "\n";
+        }
+        // Competitive ratio: online time over the best offline time, both within the budget
+        if (opts.online_lookahead > 0) {
+            auto t0 = std::chrono::steady_clock::now();
+            OnlineStats os = runOnline(bc.prob, opts.online_lookahead);
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            bool fits = os.over_budget == 0;
+            std::cout << std::left << std::setw(28) << bc.label << std::setw(44) << ("online lookahead=" + std::to_string(opts.online_lookahead))
+                      << std::right << std::setw(10) << os.total_time << std::setw(14) << os.memory_peak << std::setw(10) << "-"
+                      << std::setw(10) << static_cast<long>(wall * 1000) << "\n";
+            std::cout << "  online: " << os.recomputes << " recomputes, " << os.spills << " spills, " << os.over_budget
+                      << " over budget; competitive ratio ";
+            if (fits && bestOffline > 0) std::cout << std::setprecision(4) << static_cast<double>(os.total_time) / static_cast<double>(bestOffline) << "\n";
+            else std::cout << "- (" << (fits ? "no offline schedule fits" : "online exceeds the budget") << ")\n";
+        }
+    }
+
+    if (!opts.train_output.empty()) {
+        std::vector<size_t> all(cases.size());
+        for (size_t i = 0; i < all.size(); ++i) all[i] = i;
+        StrategySelector sel;
+        std::vector<SelectorCondition> path;
+        growTree(cases, all, opts.depth, path, cands, sel);
+        double total = 0.0;
+        SelectorRule fallback; fallback.choice = cands[bestCandidate(cases, all, total)];
+        sel.rules.push_back(fallback);
+        std::string error;
+        if (!saveStrategySelector(opts.train_output, sel, error)) { std::cerr << error << "\n"; return 1; }
+        std::cout << "selector with " << sel.rules.size() << " rules written to " << opts.train_output << "\n";
+    }
+    return 0;
+}
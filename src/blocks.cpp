@@ -0,0 +1,221 @@
+#include "blocks.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+std::string opType(const std::string& stem) {
+    auto pos = stem.rfind("-op");
+    if (pos == std::string::npos || pos + 3 == stem.size()) return stem;
+    if (stem.find_first_not_of("0123456789", pos + 3) != std::string::npos) return stem;
+    return stem.substr(0, pos);
+}
+
+// Per-node signature without edges: op type, sizes and fan-in. Time costs are left out on
+// purpose; traced repeats carry per-instance timings and replay charges the real ones.
+static uint64_t nodeSignature(const Problem& prob, NodeId id, uint64_t typeHash) {
+    const Node& n = prob.nodes[id];
+    uint64_t h = mix(typeHash, static_cast<uint64_t>(n.getRunMem()));
+    h = mix(h, static_cast<uint64_t>(n.getOutputMem()));
+    return mix(h, prob.inputs(id).size());
+}
+
+static std::vector<uint64_t> nodeSignatures(const Problem& prob) {
+    std::unordered_map<const std::string*, uint64_t> typeHash; // one entry per interned stem
+    std::vector<uint64_t> sig(prob.size());
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        const std::string& stem = prob.names.stem(id);
+        auto it = typeHash.find(&stem);
+        if (it == typeHash.end()) it = typeHash.emplace(&stem, std::hash<std::string>{}(opType(stem))).first;
+        sig[id] = nodeSignature(prob, id, it->second);
+    }
+    return sig;
+}
+
+static bool escapes(const Problem& prob, NodeId id, NodeId end) {
+    for (NodeId c : prob.consumers(id)) if (c >= end) return true;
+    return false;
+}
+
+// Exact check that [a, a + len) and [b, b + len) match position by position
+static bool sameBlock(const Problem& prob, const std::vector<uint64_t>& sig, NodeId a, NodeId b, uint32_t len) {
+    for (uint32_t j = 0; j < len; ++j) {
+        if (sig[a + j] != sig[b + j]) return false;
+        auto ia = prob.inputs(a + j), ib = prob.inputs(b + j);
+        for (size_t k = 0; k < ia.size(); ++k) {
+            NodeId x = ia.begin()[k], y = ib.begin()[k];
+            bool inA = x >= a, inB = y >= b;
+            if (inA != inB || (inA && x - a != y - b)) return false;
+        }
+        if (escapes(prob, a + j, a + len) != escapes(prob, b + j, b + len)) return false;
+    }
+    return true;
+}
+
+uint64_t blockHash(const Problem& prob, NodeId start, uint32_t length) {
+    uint64_t h = length;
+    for (uint32_t j = 0; j < length; ++j) {
+        NodeId id = start + j;
+        h = mix(h, nodeSignature(prob, id, std::hash<std::string>{}(opType(prob.names.stem(id)))));
+        for (NodeId x : prob.inputs(id)) h = mix(h, x >= start ? 1 + (id - x) : 0);
+        h = mix(h, escapes(prob, id, start + length) ? 1 : 0);
+    }
+    return h;
+}
+
+std::vector<RepeatedBlock> findRepeatedBlocks(const Problem& prob, const BlockOptions& opts) {
+    std::vector<RepeatedBlock> blocks;
+    const size_t n = prob.size();
+    for (NodeId id = 0; id < n; ++id) {
+        for (NodeId x : prob.inputs(id)) if (x >= id) return blocks;
+    }
+    auto sig = nodeSignatures(prob);
+
+    // next[i]: next position with the same signature, the only block lengths worth trying at i
+    std::vector<NodeId> next(n, static_cast<NodeId>(n));
+    std::unordered_map<uint64_t, NodeId> lastSeen;
+    for (size_t i = n; i-- > 0;) {
+        auto it = lastSeen.find(sig[i]);
+        if (it != lastSeen.end()) next[i] = it->second;
+        lastSeen[sig[i]] = static_cast<NodeId>(i);
+    }
+
+    size_t i = 0;
+    while (i + 2 * opts.min_length <= n) {
+        uint32_t bestLen = 0, bestCount = 0;
+        size_t tried = 0;
+        for (size_t p = next[i]; p < n && p - i <= opts.max_length && tried < opts.max_candidates; p = next[p], ++tried) {
+            uint32_t len = static_cast<uint32_t>(p - i);
+            if (len < opts.min_length || i + 2 * len > n) continue;
+            uint32_t count = 1;
+            while (i + (count + 1) * size_t{len} <= n &&
+                   sameBlock(prob, sig, static_cast<NodeId>(i), static_cast<NodeId>(i + count * size_t{len}), len)) ++count;
+            if (count >= 2 && size_t{count} * len > size_t{bestCount} * bestLen) { bestLen = len; bestCount = count; }
+        }
+        if (bestCount == 0) { ++i; continue; }
+        blocks.push_back({static_cast<NodeId>(i), bestLen, bestCount, blockHash(prob, static_cast<NodeId>(i), bestLen)});
+        i += size_t{bestCount} * bestLen;
+    }
+    return blocks;
+}
+
+// Block nodes with only their internal edges; boundary inputs are assumed resident. Outputs
+// read after the block stay live in the full replay, so a zero-cost sink at id `length`
+// consumes them (and every other output without an internal consumer) to keep them charged
+// until the block ends; the sink is left out when mapping the order back.
+static Problem extractBlock(const Problem& prob, NodeId start, uint32_t length, long total_memory) {
+    const NodeId end = start + length;
+    ProblemBuilder builder(total_memory);
+    builder.reserve(length + 1, 0);
+    for (uint32_t j = 0; j < length; ++j) {
+        const Node& n = prob.nodes[start + j];
+        builder.addNode(prob.name(start + j), n.getRunMem(), n.getOutputMem(), n.getTimeCost());
+        for (NodeId x : prob.inputs(start + j)) if (x >= start) builder.addInput(x - start);
+    }
+    bool anyEscape = false;
+    for (NodeId id = start; id < end && !anyEscape; ++id) anyEscape = escapes(prob, id, end);
+    if (anyEscape) {
+        builder.addNode(prob.name(start) + "/sink", 0, 0, 0);
+        for (uint32_t j = 0; j < length; ++j) {
+            bool internal = false;
+            for (NodeId c : prob.consumers(start + j)) if (c < end) { internal = true; break; }
+            if (!internal || escapes(prob, start + j, end)) builder.addInput(j);
+        }
+    }
+    Problem block = builder.finish();
+    if (!prob.recompute_cost.empty()) {
+        block.recompute_cost.assign(prob.recompute_cost.begin() + start, prob.recompute_cost.begin() + end);
+        block.recompute_cost.resize(block.size(), 0);
+    }
+    if (!prob.storage.empty()) {
+        block.storage.assign(prob.storage.begin() + start, prob.storage.begin() + end);
+        block.storage.resize(block.size());
+    }
+    // An in-place node whose first input lies outside the block has nothing to overwrite there
+    for (uint32_t j = 0; j < length; ++j) {
+        if (prob.in_place.test(start + j) && *prob.inputs(start + j).begin() >= start) block.in_place.set(j);
+    }
+    return block;
+}
+
+// Memory held by earlier outputs when each id starts, executing in id order
+static std::vector<long> liveBefore(const Problem& prob) {
+    std::vector<uint32_t> remaining(prob.size());
+    for (NodeId id = 0; id < prob.size(); ++id) remaining[id] = static_cast<uint32_t>(prob.consumers(id).size());
+    std::vector<long> live(prob.size());
+    long current = 0;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        live[id] = current;
+        current += prob.nodes[id].getOutputMem();
+        for (NodeId in : prob.inputs(id)) if (--remaining[in] == 0) current -= prob.nodes[in].getOutputMem();
+        if (remaining[id] == 0) current -= prob.nodes[id].getOutputMem();
+    }
+    return live;
+}
+
+ScheduleState blockReplicatedSchedule(const Problem& prob, const BlockOptions& opts, std::vector<RepeatedBlock>* found) {
+    auto blocks = findRepeatedBlocks(prob, opts);
+    if (found) *found = blocks;
+    auto live = liveBefore(prob);
+    auto sig = nodeSignatures(prob);
+
+    // Group runs into shapes: equal hash, confirmed by an exact match against the first run
+    std::vector<size_t> shapeOf(blocks.size());
+    std::vector<size_t> shapeRep; // block index representing each shape
+    std::unordered_multimap<uint64_t, size_t> byHash;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const RepeatedBlock& b = blocks[i];
+        shapeOf[i] = shapeRep.size();
+        auto range = byHash.equal_range(b.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const RepeatedBlock& r = blocks[shapeRep[it->second]];
+            if (r.length == b.length && sameBlock(prob, sig, r.start, b.start, b.length)) { shapeOf[i] = it->second; break; }
+        }
+        if (shapeOf[i] == shapeRep.size()) { byHash.emplace(b.hash, shapeRep.size()); shapeRep.push_back(i); }
+    }
+
+    // One search per shape, under the tightest boundary among all of its instances
+    std::vector<long> liveIn(shapeRep.size(), 0);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const RepeatedBlock& b = blocks[i];
+        for (uint32_t k = 0; k < b.count; ++k) liveIn[shapeOf[i]] = std::max(liveIn[shapeOf[i]], live[b.start + k * b.length]);
+    }
+    std::vector<std::vector<ScheduleStep>> shapeOrder(shapeRep.size());
+    for (size_t sh = 0; sh < shapeRep.size(); ++sh) {
+        const RepeatedBlock& b = blocks[shapeRep[sh]];
+        // Nothing left for the block once the outputs live into it are charged: no replay fits
+        long budget = prob.total_memory - liveIn[sh];
+        if (budget <= 0 && !opts.relax_budget) return ScheduleState{};
+        Problem sub = extractBlock(prob, b.start, b.length, budget > 0 ? budget : prob.total_memory);
+        ScheduleState s;
+        if (!opts.cache || !opts.cache->lookup(b.hash, sub, sub.total_memory, s)) {
+            s = dfsScheduleLimited(sub, opts.max_expansions, opts.time_limit);
+            if (s.computed.count() != sub.size()) s = prioritySchedule(sub, defaultPriorityWeights());
+            if (opts.cache && s.computed.count() == sub.size() && s.memory_peak <= sub.total_memory) opts.cache->offer(b.hash, sub.total_memory, s);
+        }
+        if (s.computed.count() == sub.size()) {
+            for (const ScheduleStep& st : s.execution_order) if (st.node() < b.length) shapeOrder[sh].push_back(st);
+        } else {
+            for (NodeId j = 0; j < b.length; ++j) shapeOrder[sh].emplace_back(j, false);
+        }
+    }
+
+    std::vector<ScheduleStep> order;
+    order.reserve(prob.size());
+    NodeId id = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const RepeatedBlock& b = blocks[i];
+        for (; id < b.start; ++id) order.emplace_back(id, false);
+        for (uint32_t k = 0; k < b.count; ++k) {
+            NodeId base = b.start + k * b.length;
+            for (const ScheduleStep& st : shapeOrder[shapeOf[i]]) order.emplace_back(base + st.node(), st.isRecompute());
+        }
+        id = b.start + b.count * b.length;
+    }
+    for (; id < prob.size(); ++id) order.emplace_back(id, false);
+    return replaySchedule(prob, order);
+}
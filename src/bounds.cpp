@@ -0,0 +1,49 @@
+#include "bounds.hpp"
+#include <algorithm>
+
+ScheduleBounds computeScheduleBounds(const Problem& prob) {
+    ScheduleBounds b;
+    const size_t n = prob.size();
+    std::vector<long> need(n);
+    std::vector<NodeId> stamp(n, kNoNode); // counts each input once per node
+    for (NodeId id = 0; id < n; ++id) {
+        const Node& node = prob.nodes[id];
+        long m = node.getPeak();
+        // An in-place op may write over its first input (at most that input's size)
+        if (prob.in_place.test(id)) {
+            long out = node.getOutputMem();
+            m = std::max<long>(node.getRunMem(), out - std::min<long>(out, prob.nodes[*prob.inputs(id).begin()].getOutputMem()));
+        }
+        for (NodeId x : prob.inputs(id)) {
+            if (stamp[x] == id) continue;
+            stamp[x] = id;
+            m += prob.nodes[x].getOutputMem();
+        }
+        need[id] = m;
+        if (b.peak_node == kNoNode || m > b.peak) { b.peak = m; b.peak_node = id; }
+        b.time += node.getTimeCost();
+    }
+
+    for (NodeId c = 0; c < n; ++c) {
+        NodeId a = kNoNode, d = kNoNode; // two distinct inputs with the largest outputs
+        for (NodeId x : prob.inputs(c)) {
+            if (x == a || x == d) continue;
+            if (a == kNoNode || prob.nodes[x].getOutputMem() > prob.nodes[a].getOutputMem()) { d = a; a = x; }
+            else if (d == kNoNode || prob.nodes[x].getOutputMem() > prob.nodes[d].getOutputMem()) d = x;
+        }
+        if (d == kNoNode) continue;
+        // A feeding B (or the reverse) changes the argument: it is never resident across the other's run
+        bool linked = false;
+        for (NodeId x : prob.inputs(a)) if (x == d) linked = true;
+        for (NodeId x : prob.inputs(d)) if (x == a) linked = true;
+        if (linked) continue;
+        long aFirst = need[d] + prob.nodes[a].getOutputMem();
+        long dFirst = need[a] + prob.nodes[d].getOutputMem();
+        if (aFirst > prob.total_memory && dFirst > prob.total_memory) {
+            b.forced_recompute = std::max<long>(b.forced_recompute,
+                                                std::min(prob.recomputeCost(a), prob.recomputeCost(d)));
+        }
+    }
+    b.time += b.forced_recompute;
+    return b;
+}
@@ -0,0 +1,162 @@
+#include "cp.hpp"
+#include "bounds.hpp"
+#include "transposition.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+
+struct CpSearch {
+    const Problem& prob;
+    const CpOptions& opts;
+    CpStats& st;
+    PriorityScales scales;
+    std::vector<NodeId> symPrev;
+    std::vector<long> staticNeed; // inputs + run + output memory of each node
+    TranspositionTable nogoods;
+    std::chrono::steady_clock::time_point deadline;
+    ScheduleState best;
+    bool has_best{false};
+    bool aborted{false};
+    long frontier{std::numeric_limits<long>::max()}; // smallest bound left unexplored on abort
+
+    CpSearch(const Problem& p, const CpOptions& o, CpStats& s)
+        : prob(p), opts(o), st(s), scales(priorityScales(p)), symPrev(interchangeablePredecessors(p)),
+          staticNeed(p.size()), nogoods(o.nogood_entries ? o.nogood_entries : 1) {
+        for (NodeId id = 0; id < p.size(); ++id) {
+            const Node& node = p.nodes[id];
+            long need = node.getPeak();
+            // An in-place op may write over its first input (at most that input's size)
+            if (p.in_place.test(id)) {
+                long out = node.getOutputMem();
+                need = std::max<long>(node.getRunMem(), out - std::min<long>(out, p.nodes[*p.inputs(id).begin()].getOutputMem()));
+            }
+            for (NodeId x : p.inputs(id)) need += p.nodes[x].getOutputMem();
+            staticNeed[id] = need;
+        }
+    }
+
+    // Memory propagation: extra time any completion must spend on recomputation. While v waits,
+    // resident outputs feeding another consumer of v stay pinned across v's run; if they do not
+    // fit together with v, at least one of them is dropped and must run again.
+    long forcedRecompute(const ScheduleState& s) const {
+        long forced = 0;
+        std::vector<NodeId> seen;
+        for (NodeId v = 0; v < prob.size(); ++v) {
+            if (s.computed.test(v)) continue;
+            long pinned = 0, cheapest = std::numeric_limits<long>::max();
+            seen.clear();
+            for (NodeId c : prob.consumers(v)) {
+                for (NodeId x : prob.inputs(c)) {
+                    if (x == v || !s.resident.test(x)) continue;
+                    auto in = prob.inputs(v);
+                    if (std::find(in.begin(), in.end(), x) != in.end()) continue;
+                    if (std::find(seen.begin(), seen.end(), x) != seen.end()) continue;
+                    seen.push_back(x);
+                    pinned += prob.nodes[x].getOutputMem();
+                    cheapest = std::min<long>(cheapest, prob.recomputeCost(x));
+                }
+            }
+            if (pinned > 0 && staticNeed[v] + pinned > prob.total_memory) forced = std::max(forced, cheapest);
+        }
+        return forced;
+    }
+
+    long bound(const ScheduleState& s) const {
+        return s.total_time + remainingTimeLowerBound(prob, s) + forcedRecompute(s);
+    }
+
+    void solve(ScheduleState& s, NodeId minSpill) {
+        garbageCollectOutputs(prob, s);
+        if (s.computed.count() == prob.size()) {
+            if (!has_best || isBetterSchedule(s, best, prob.total_memory)) { best = s; has_best = true; }
+            return;
+        }
+        long lb = bound(s);
+        if (aborted || st.nodes >= opts.max_nodes ||
+            ((st.nodes & 0xFF) == 0 && std::chrono::steady_clock::now() > deadline)) {
+            aborted = true;
+            frontier = std::min(frontier, lb);
+            return;
+        }
+        ++st.nodes;
+        // Drop/recompute cycles could otherwise recurse until the stack runs out
+        if (s.execution_order.size() > 4 * prob.size() + 16) { ++st.failures; return; }
+        if (has_best && lb >= best.total_time) { ++st.bound_prunes; return; }
+        // Drops below minSpill are off limits in this subtree, so it only covers equal minSpill
+        uint64_t key = stateKey(s) + 0x9e3779b97f4a7c15ull * minSpill;
+        if (nogoods.dominated(key, s.total_time, s.memory_peak)) { ++st.nogood_hits; return; }
+
+        // Positions: first runs in priority order, recomputes only when no first run fits
+        auto ready = getReadyNodes(prob, s);
+        ready.erase(std::remove_if(ready.begin(), ready.end(), [&](NodeId id) {
+            return symPrev[id] != kNoNode && !s.computed.test(symPrev[id]);
+        }), ready.end());
+        std::vector<std::pair<double, NodeId>> moves;
+        auto addFitting = [&](const std::vector<NodeId>& ids) {
+            for (NodeId id : ids) {
+                if (calculateSequentialPeak(prob, id, s) > prob.total_memory) continue;
+                moves.emplace_back(priorityScore(prob, s, id, opts.weights, scales), id);
+            }
+        };
+        addFitting(ready);
+        if (moves.empty()) addFitting(getRecomputeCandidates(prob, s));
+        std::sort(moves.begin(), moves.end());
+        for (const auto& m : moves) {
+            ScheduleState next = s;
+            applyNode(m.second, prob, next);
+            solve(next, 0); // after an abort the remaining children only report their bounds
+        }
+
+        // Keep/recompute: nothing fits, so branch on which needed output to drop. Successive drops
+        // go in increasing id order, so each set of dropped outputs is tried once.
+        if (moves.empty()) {
+            std::vector<std::pair<double, NodeId>> drops;
+            s.resident.forEach([&](NodeId x) {
+                if (x < minSpill) return;
+                double t = std::max(1, prob.recomputeCost(x));
+                drops.emplace_back(-prob.nodes[x].getOutputMem() / t, x);
+            });
+            if (drops.empty()) ++st.failures;
+            std::sort(drops.begin(), drops.end());
+            for (const auto& d : drops) {
+                ScheduleState next = s;
+                spillOutput(prob, next, d.second);
+                solve(next, d.second + 1);
+            }
+        }
+        if (!aborted) nogoods.store(key, s.total_time, s.memory_peak);
+    }
+};
+
+} // namespace
+
+ScheduleState cpSchedule(const Problem& prob, const CpOptions& opts, CpStats* stats) {
+    CpStats local;
+    CpStats& st = stats ? *stats : local;
+    st = CpStats{};
+    CpSearch search(prob, opts, st);
+    search.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(opts.time_limit > 0.0 ? opts.time_limit : 5.0));
+
+    ScheduleState init;
+    ScheduleBounds root = computeScheduleBounds(prob);
+    st.lower_bound = std::max(search.bound(init), root.time);
+    if (!boundsFeasible(prob, root)) { st.infeasible = true; return ScheduleState{}; }
+    // Seed the incumbent with the priority rollout so the bound prunes from the first node
+    ScheduleState seed = prioritySchedule(prob, opts.weights);
+    if (seed.computed.count() == prob.size() && seed.memory_peak <= prob.total_memory) {
+        search.best = seed;
+        search.has_best = true;
+    }
+    search.solve(init, 0);
+
+    if (search.has_best) {
+        st.upper_bound = search.best.total_time;
+        st.lower_bound = search.aborted ? std::max(st.lower_bound, std::min(search.frontier, st.upper_bound)) : st.upper_bound;
+    } else if (search.aborted) {
+        st.lower_bound = std::max(st.lower_bound, search.frontier == std::numeric_limits<long>::max() ? 0 : search.frontier);
+    }
+    return search.has_best ? search.best : ScheduleState{};
+}
@@ -0,0 +1,139 @@
+#include "cyclic.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <limits>
+
+Problem steadyStateProblem(const Problem& prob, const NodeBitset& carried, std::vector<NodeId>& original) {
+    long held = 0;
+    carried.forEach([&](NodeId id) { held += prob.nodes[id].getOutputMem(); });
+    std::vector<NodeId> local(prob.size(), kNoNode);
+    original.clear();
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        if (carried.test(id)) continue;
+        local[id] = static_cast<NodeId>(original.size());
+        original.push_back(id);
+    }
+    ProblemBuilder builder(prob.total_memory - held);
+    builder.reserve(original.size(), prob.input_ids.size());
+    for (NodeId id : original) {
+        const Node& n = prob.nodes[id];
+        builder.addNode(prob.name(id), n.getRunMem(), n.getOutputMem(), n.getTimeCost());
+        for (NodeId x : prob.inputs(id)) if (!carried.test(x)) builder.addInput(local[x]);
+    }
+    Problem steady = builder.finish();
+    if (!prob.recompute_cost.empty()) {
+        for (NodeId id : original) steady.recompute_cost.push_back(prob.recompute_cost[id]);
+    }
+    if (!prob.storage.empty()) {
+        for (NodeId id : original) steady.storage.push_back(prob.storage[id]);
+    }
+    // A carried first input never dies, so there is nothing to overwrite
+    for (NodeId v = 0; v < steady.size(); ++v) {
+        NodeId id = original[v];
+        if (prob.in_place.test(id) && !carried.test(*prob.inputs(id).begin())) steady.in_place.set(v);
+    }
+    return steady;
+}
+
+ScheduleState cyclicSchedule(const Problem& prob, const IterationScheduler& schedule, const CyclicOptions& opts,
+                             CyclicStats* stats, NodeBitset* carried) {
+    CyclicStats local;
+    CyclicStats& st = stats ? *stats : local;
+    st = CyclicStats{};
+
+    // Candidates by time saved per byte held; zero-time sources save nothing
+    std::vector<std::pair<double, NodeId>> ranked;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        if (!prob.inputs(id).empty() || (opts.candidates && !opts.candidates->test(id))) continue;
+        if (prob.nodes[id].getTimeCost() <= 0) continue;
+        double out = std::max(1, prob.nodes[id].getOutputMem());
+        ranked.emplace_back(-prob.nodes[id].getTimeCost() / out, id);
+    }
+    std::sort(ranked.begin(), ranked.end());
+    st.candidates = ranked.size();
+    // Prefixes whose outputs alone exceed the budget cannot fit
+    size_t hi = 0;
+    for (long held = 0; hi < ranked.size(); ++hi) {
+        held += prob.nodes[ranked[hi].second].getOutputMem();
+        if (held > prob.total_memory) break;
+    }
+
+    struct Probe {
+        ScheduleState state; // in prob's ids
+        NodeBitset carried;
+        long held{0};
+        bool fits{false};
+    };
+    auto run = [&](size_t k) {
+        Probe p;
+        for (size_t i = 0; i < k; ++i) {
+            p.carried.set(ranked[i].second);
+            p.held += prob.nodes[ranked[i].second].getOutputMem();
+        }
+        std::vector<NodeId> original;
+        Problem steady = steadyStateProblem(prob, p.carried, original);
+        ScheduleState s = schedule(steady);
+        ++st.probes;
+        p.fits = s.computed.count() == steady.size() && s.memory_peak <= steady.total_memory;
+        for (const ScheduleStep& step : s.execution_order) p.state.execution_order.emplace_back(original[step.node()], step.isRecompute());
+        p.state.current_memory = s.current_memory + p.held;
+        p.state.memory_peak = s.memory_peak + p.held;
+        p.state.total_time = s.total_time;
+        s.computed.forEach([&](NodeId v) { p.state.computed.set(original[v]); });
+        s.resident.forEach([&](NodeId v) { p.state.resident.set(original[v]); });
+        p.carried.forEach([&](NodeId id) { p.state.computed.set(id); p.state.resident.set(id); });
+        return p;
+    };
+    auto better = [&](const Probe& a, const Probe& b) {
+        if (a.fits != b.fits) return a.fits;
+        if (a.fits) return a.state.total_time < b.state.total_time;
+        bool ac = a.state.computed.count() == prob.size(), bc = b.state.computed.count() == prob.size();
+        if (ac != bc) return ac;
+        return a.state.memory_peak < b.state.memory_peak;
+    };
+
+    // Carrying nothing is the one-pass problem; when even that does not fit, carrying cannot help.
+    // Otherwise carrying more saves time but leaves less budget: the most that fits is probed
+    // first, then a prefix held within the one-pass headroom (the one-pass order minus those
+    // sources stays within budget, so this fits unless the scheduler does worse), then bisection.
+    Probe best = run(0);
+    if (best.fits && hi > 0) {
+        auto consider = [&](size_t k) {
+            Probe p = run(k);
+            bool fits = p.fits;
+            if (better(p, best)) best = std::move(p);
+            return fits;
+        };
+        size_t room = 0;
+        for (long held = 0, headroom = prob.total_memory - best.state.memory_peak; room < hi; ++room) {
+            held += prob.nodes[ranked[room].second].getOutputMem();
+            if (held > headroom) break;
+        }
+        size_t good = 0, bad = hi;
+        if (consider(hi)) good = hi;
+        else if (room > 0) { if (consider(room)) good = room; else bad = room; }
+        while (good + 1 < bad && st.probes < std::max<size_t>(3, opts.max_probes)) {
+            size_t mid = good + (bad - good) / 2;
+            if (consider(mid)) good = mid; else bad = mid;
+        }
+    }
+
+    // Warm-up: the carried sources first, each held from its run on
+    long warmHeld = 0, warmPeak = 0, warmTime = 0;
+    for (const auto& r : ranked) {
+        if (!best.carried.test(r.second)) continue;
+        const Node& n = prob.nodes[r.second];
+        warmPeak = std::max(warmPeak, warmHeld + n.getPeak());
+        warmHeld += n.getOutputMem();
+        warmTime += n.getTimeCost();
+    }
+    st.carried = best.carried.count();
+    st.carried_memory = best.held;
+    st.steady_time = best.state.total_time;
+    st.steady_peak = best.state.memory_peak;
+    st.warmup_time = warmTime + st.steady_time;
+    st.warmup_peak = std::max(warmPeak, st.steady_peak);
+    st.fits = best.fits;
+    if (carried) *carried = std::move(best.carried);
+    return std::move(best.state);
+}
@@ -0,0 +1,91 @@
+#include "features.hpp"
+#include <algorithm>
+#include <queue>
+
+static const char* const kFeatureNames[GF_Count] = {
+    "nodes",
+    "edges",
+    "max_fan_in",
+    "width",
+    "budget_ratio",
+    "chain_fraction",
+};
+
+const char* graphFeatureName(int feature) {
+    if (feature < 0 || feature >= GF_Count) return "";
+    return kFeatureNames[feature];
+}
+
+int graphFeatureIndex(const std::string& name) {
+    for (int f = 0; f < GF_Count; ++f) {
+        if (name == kFeatureNames[f]) return f;
+    }
+    return -1;
+}
+
+// Kahn's algorithm in FIFO order; returns an empty vector on cycles.
+static std::vector<NodeId> topologicalOrder(const Problem& prob) {
+    std::vector<uint32_t> indeg(prob.size());
+    std::queue<NodeId> q;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        indeg[id] = static_cast<uint32_t>(prob.inputs(id).size());
+        if (indeg[id] == 0) q.push(id);
+    }
+    std::vector<NodeId> order;
+    order.reserve(prob.size());
+    while (!q.empty()) {
+        NodeId u = q.front(); q.pop();
+        order.push_back(u);
+        for (NodeId v : prob.consumers(u)) {
+            if (--indeg[v] == 0) q.push(v);
+        }
+    }
+    if (order.size() != prob.size()) order.clear();
+    return order;
+}
+
+long topologicalSweepPeak(const Problem& prob) {
+    std::vector<uint32_t> remaining(prob.size());
+    for (NodeId id = 0; id < prob.size(); ++id) remaining[id] = static_cast<uint32_t>(prob.consumers(id).size());
+    long current = 0, peak = 0;
+    for (NodeId id : topologicalOrder(prob)) {
+        const Node& node = prob.nodes[id];
+        peak = std::max(peak, current + node.getPeak());
+        current += node.getOutputMem();
+        for (NodeId in : prob.inputs(id)) {
+            if (--remaining[in] == 0) current -= prob.nodes[in].getOutputMem();
+        }
+        if (remaining[id] == 0) current -= node.getOutputMem();
+    }
+    return peak;
+}
+
+GraphFeatures computeGraphFeatures(const Problem& prob) {
+    GraphFeatures gf;
+    size_t maxFanIn = 0, chains = 0;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        size_t fanIn = prob.inputs(id).size();
+        maxFanIn = std::max(maxFanIn, fanIn);
+        if (fanIn <= 1 && prob.consumers(id).size() <= 1) ++chains;
+    }
+
+    // Longest-path levels give a cheap estimate of how many nodes can be live side by side
+    std::vector<uint32_t> level(prob.size(), 0);
+    std::vector<size_t> perLevel;
+    for (NodeId id : topologicalOrder(prob)) {
+        uint32_t lv = 0;
+        for (NodeId in : prob.inputs(id)) lv = std::max(lv, level[in] + 1);
+        level[id] = lv;
+        if (perLevel.size() <= lv) perLevel.resize(lv + 1, 0);
+        ++perLevel[lv];
+    }
+
+    long sweepPeak = topologicalSweepPeak(prob);
+    gf.v[GF_Nodes] = static_cast<double>(prob.size());
+    gf.v[GF_Edges] = static_cast<double>(prob.input_ids.size());
+    gf.v[GF_MaxFanIn] = static_cast<double>(maxFanIn);
+    gf.v[GF_Width] = perLevel.empty() ? 0.0 : static_cast<double>(*std::max_element(perLevel.begin(), perLevel.end()));
+    gf.v[GF_BudgetRatio] = sweepPeak > 0 ? static_cast<double>(prob.total_memory) / static_cast<double>(sweepPeak) : 0.0;
+    gf.v[GF_ChainFraction] = prob.nodes.empty() ? 0.0 : static_cast<double>(chains) / static_cast<double>(prob.size());
+    return gf;
+}
@@ -0,0 +1,118 @@
+#include "hugepages.hpp"
+#include <new>
+#ifdef __linux__
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+std::atomic<int> g_mode{static_cast<int>(HugePageMode::Off)};
+std::atomic<size_t> g_explicit{0}, g_transparent{0}, g_plain{0}, g_fallbacks{0};
+
+} // namespace
+
+bool parseHugePageMode(const std::string& text, HugePageMode& out) {
+    if (text == "off") out = HugePageMode::Off;
+    else if (text == "thp") out = HugePageMode::Transparent;
+    else if (text == "explicit") out = HugePageMode::Explicit;
+    else return false;
+    return true;
+}
+
+const char* hugePageModeName(HugePageMode mode) {
+    switch (mode) {
+    case HugePageMode::Off: return "off";
+    case HugePageMode::Transparent: return "thp";
+    case HugePageMode::Explicit: return "explicit";
+    }
+    return "?";
+}
+
+void setHugePageMode(HugePageMode mode) { g_mode.store(static_cast<int>(mode)); }
+HugePageMode hugePageMode() { return static_cast<HugePageMode>(g_mode.load()); }
+
+HugePageStats hugePageStats() {
+    HugePageStats st;
+    st.explicit_bytes = g_explicit.load();
+    st.transparent_bytes = g_transparent.load();
+    st.plain_bytes = g_plain.load();
+    st.fallbacks = g_fallbacks.load();
+    return st;
+}
+
+#ifdef __linux__
+
+namespace {
+
+size_t roundUp(size_t bytes) { return (bytes + kHugePageBytes - 1) & ~(kHugePageBytes - 1); }
+
+// Live mappings and the counter each was charged to; only buffers of 2 MiB and more get here
+std::mutex g_mu;
+std::unordered_map<void*, std::atomic<size_t>*> g_mappings;
+
+// Page-aligned mapping trimmed to a 2 MiB boundary, so whole huge pages fit
+void* mapAligned(size_t len) {
+    void* raw = mmap(nullptr, len + kHugePageBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + kHugePageBytes - 1) & ~(uintptr_t(kHugePageBytes) - 1);
+    if (aligned > start) munmap(raw, aligned - start);
+    size_t tail = start + len + kHugePageBytes - (aligned + len);
+    if (tail) munmap(reinterpret_cast<void*>(aligned + len), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void* track(void* p, size_t len, std::atomic<size_t>& counter) {
+    counter += len;
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_mappings[p] = &counter;
+    return p;
+}
+
+} // namespace
+
+void* allocateHugeCapable(size_t bytes) {
+    if (bytes < kHugePageBytes) return ::operator new(bytes);
+    const size_t len = roundUp(bytes);
+    const HugePageMode mode = hugePageMode();
+    if (mode == HugePageMode::Explicit) {
+        void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return track(p, len, g_explicit);
+        ++g_fallbacks; // pool empty or not configured
+    }
+    void* p = mapAligned(len);
+    if (!p) throw std::bad_alloc();
+    if (mode != HugePageMode::Off && madvise(p, len, MADV_HUGEPAGE) == 0) return track(p, len, g_transparent);
+    return track(p, len, g_plain);
+}
+
+void deallocateHugeCapable(void* p, size_t bytes) {
+    if (!p) return;
+    if (bytes < kHugePageBytes) { ::operator delete(p); return; }
+    const size_t len = roundUp(bytes);
+    std::atomic<size_t>* counter = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        auto it = g_mappings.find(p);
+        if (it != g_mappings.end()) { counter = it->second; g_mappings.erase(it); }
+    }
+    if (counter) *counter -= len;
+    munmap(p, len);
+}
+
+#else
+
+void* allocateHugeCapable(size_t bytes) {
+    if (bytes >= kHugePageBytes) g_plain += bytes;
+    return ::operator new(bytes);
+}
+
+void deallocateHugeCapable(void* p, size_t bytes) {
+    if (bytes >= kHugePageBytes) g_plain -= bytes;
+    ::operator delete(p);
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "lds.hpp"
+#include "numa.hpp"
+#include "parallel.hpp"
+#include "transposition.hpp"
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <random>
+
+size_t lubyTerm(size_t i) {
+    size_t k = i + 1;
+    for (;;) {
+        size_t p = 1;
+        while ((size_t{1} << p) - 1 < k) ++p;
+        if ((size_t{1} << p) - 1 == k) return size_t{1} << (p - 1);
+        k -= (size_t{1} << (p - 1)) - 1;
+    }
+}
+
+namespace {
+
+const size_t kUnlimited = std::numeric_limits<size_t>::max();
+
+// State shared by every worker: the incumbent, whose time prunes all runs, and the budget
+struct Shared {
+    const Problem& prob;
+    const DiversifiedOptions& opts;
+    std::vector<NodeId> symPrev;
+    std::chrono::steady_clock::time_point deadline;
+    std::mutex mu;
+    ScheduleState best;
+    bool has_best{false};
+    std::atomic<long> bestTime{std::numeric_limits<long>::max()};
+    std::atomic<size_t> expansions{0};
+    std::atomic<bool> timedOut{false};
+    NumaTopology topo;
+    std::unique_ptr<ProblemReplicas> replicas; // multi-node hosts with opts.numa
+
+    Shared(const Problem& p, const DiversifiedOptions& o) : prob(p), opts(o), symPrev(interchangeablePredecessors(p)) {
+        deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(o.time_limit > 0.0 ? o.time_limit : 5.0));
+        if (o.numa) {
+            topo = detectNumaTopology();
+            if (topo.multiNode()) replicas.reset(new ProblemReplicas(p, topo));
+        }
+    }
+    bool exhausted() const { return timedOut.load(std::memory_order_relaxed) || expansions.load(std::memory_order_relaxed) >= opts.max_expansions; }
+    void offer(const ScheduleState& s) {
+        std::lock_guard<std::mutex> lock(mu);
+        if (!has_best || isBetterSchedule(s, best, prob.total_memory)) {
+            best = s;
+            has_best = true;
+            bestTime.store(s.total_time);
+        }
+    }
+};
+
+// One depth-first run. `discrepancies` caps the non-first choices on a path; with `rng` set the
+// heuristic order is perturbed instead. `left` caps this run's own expansions.
+class Run {
+public:
+    Run(Shared& sh, const Problem& prob, size_t left, std::mt19937_64* rng, ConcurrentTranspositionTable* shared = nullptr)
+        : sh_(sh), prob_(prob), left_(left), rng_(rng), seen_(2 * std::min<size_t>(left, size_t{1} << 15)), shared_(shared) {}
+
+    void dfs(ScheduleState& s, size_t discrepancies) {
+        const Problem& prob = prob_;
+        if (stop_) return;
+        if (s.computed.count() == prob.size()) { sh_.offer(s); return; }
+        if (s.execution_order.size() > 4 * prob.size() + 16) return; // recompute/spill cycle
+        if (s.total_time + remainingTimeLowerBound(prob, s) >= sh_.bestTime.load(std::memory_order_relaxed)) return;
+        uint64_t key = stateKey(s);
+        if (seen_.dominated(key, s.total_time, s.memory_peak, discrepancies)) return;
+        if (shared_ && shared_->dominated(key, s.total_time, s.memory_peak)) return;
+        seen_.store(key, s.total_time, s.memory_peak, discrepancies);
+        if (left_ == 0 || sh_.exhausted()) { stop_ = true; return; }
+        --left_;
+        size_t done = sh_.expansions.fetch_add(1, std::memory_order_relaxed);
+        if ((done & 0xFF) == 0 && std::chrono::steady_clock::now() > sh_.deadline) sh_.timedOut = true;
+
+        auto moves = heuristicMoves(prob, s, sh_.symPrev);
+        if (moves.empty()) {
+            ScheduleState spilled = s;
+            if (spillForProgress(prob, spilled)) dfs(spilled, discrepancies);
+            if (shared_ && !stop_) shared_->store(key, s.total_time, s.memory_peak);
+            return;
+        }
+        if (rng_) {
+            std::uniform_int_distribution<int> coin(0, 3);
+            for (size_t i = 0; i + 1 < moves.size(); ++i) if (coin(*rng_) == 0) std::swap(moves[i], moves[i + 1]);
+        }
+        for (size_t i = 0; i < moves.size() && !stop_; ++i) {
+            if (i > 0 && discrepancies == 0) break;
+            ScheduleState next = s;
+            applyNode(moves[i], prob, next);
+            dfs(next, i == 0 || discrepancies == kUnlimited ? discrepancies : discrepancies - 1);
+        }
+        // Other runs may skip this state only once its subtree has been searched to the end
+        if (shared_ && !stop_) shared_->store(key, s.total_time, s.memory_peak);
+    }
+
+private:
+    Shared& sh_;
+    const Problem& prob_; // the worker's node-local replica
+    size_t left_;
+    std::mt19937_64* rng_;
+    TranspositionTable seen_; // per run, with the discrepancies left: only a revisit with no more left is pruned
+    ConcurrentTranspositionTable* shared_; // restarts: states whose subtree some run finished
+    bool stop_{false};
+};
+
+// Work items over the threads, each given its worker's copy of the graph
+template <class Body>
+void forEachRun(Shared& sh, size_t count, Body&& body) {
+    if (sh.replicas) {
+        numaParallelFor(count, sh.opts.threads, sh.topo, [&](size_t i, size_t, size_t node) { body(i, sh.replicas->local(node)); });
+    } else {
+        parallelFor(count, sh.opts.threads, [&](size_t i, size_t) { body(i, sh.prob); });
+    }
+}
+
+} // namespace
+
+ScheduleState ldsSchedule(const Problem& prob, const DiversifiedOptions& opts, DiversifiedStats* stats) {
+    Shared sh(prob, opts);
+    forEachRun(sh, opts.max_discrepancies + 1, [&](size_t k, const Problem& local) {
+        if (sh.exhausted()) return;
+        Run run(sh, local, kUnlimited, nullptr);
+        ScheduleState init;
+        run.dfs(init, k);
+    });
+    if (stats) stats->expansions = sh.expansions.load();
+    return sh.has_best ? sh.best : ScheduleState{};
+}
+
+ScheduleState restartSchedule(const Problem& prob, const DiversifiedOptions& opts, DiversifiedStats* stats) {
+    Shared sh(prob, opts);
+    const size_t unit = std::max<size_t>(1, opts.luby_unit);
+    std::unique_ptr<ConcurrentTranspositionTable> shared;
+    if (opts.shared_entries) shared.reset(new ConcurrentTranspositionTable(opts.shared_entries));
+    // Every run costs at least one unit, which bounds the number of runs
+    forEachRun(sh, opts.max_expansions / unit + 1, [&](size_t r, const Problem& local) {
+        if (sh.exhausted()) return;
+        std::mt19937_64 rng(opts.seed * 0x9e3779b97f4a7c15ull + r);
+        Run run(sh, local, lubyTerm(r) * unit, r == 0 ? nullptr : &rng, shared.get()); // run 0 follows the plain heuristic order
+        ScheduleState init;
+        run.dfs(init, kUnlimited);
+    });
+    if (stats) stats->expansions = sh.expansions.load();
+    return sh.has_best ? sh.best : ScheduleState{};
+}
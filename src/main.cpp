@@ -1,108 +1,293 @@
+#include "blocks.hpp"
+#include "bounds.hpp"
+#include "cyclic.hpp"
+#include "op_registry.hpp"
 #include "parser.hpp"
-#include "scheduler.hpp"
-#include <fstream>
+#include "remat.hpp"
+#include "selector.hpp"
+#include "streaming.hpp"
+#include "tabu.hpp"
+#include "tiers.hpp"
 #include <iostream>
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cout << "Usage: scheduler <input_file>\n";
+        std::cout << "Usage: scheduler <input_file> [--weights <weights_file>] [--selector <rules_file>] [--stream <order_file>] [--cache <cache_file>] [--ops <op_registry_file>] [--cyclic] [--tiers <tier_file>] [--huge-pages off|thp|explicit]\n";
         return 0;
     }
-    std::ifstream fin(argv[1]);
-    if (!fin) {
-        std::cerr << "Failed to open input: " << argv[1] << "\n";
-        return 1;
+    // Optional tuned priority weights (written by tune_weights) and selector rules (written by bench)
+    bool have_weights = false, cyclic = false; PriorityWeights weights = defaultPriorityWeights();
+    StrategySelector selector = defaultStrategySelector();
+    std::string stream_output, cache_path, ops_path, tiers_path;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--selector" && i + 1 < argc) {
+            std::string serr;
+            if (!loadStrategySelector(argv[++i], selector, serr)) {
+                std::cerr << serr << "\n";
+                return 1;
+            }
+        } else if (arg == "--weights" && i + 1 < argc) {
+            std::string werr;
+            if (!loadPriorityWeights(argv[++i], weights, werr)) {
+                std::cerr << werr << "\n";
+                return 1;
+            }
+            have_weights = true;
+        } else if (arg == "--stream" && i + 1 < argc) {
+            stream_output = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (arg == "--ops" && i + 1 < argc) {
+            ops_path = argv[++i];
+        } else if (arg == "--tiers" && i + 1 < argc) {
+            tiers_path = argv[++i];
+        } else if (arg == "--huge-pages" && i + 1 < argc) {
+            HugePageMode mode;
+            if (!parseHugePageMode(argv[++i], mode)) {
+                std::cerr << "Unknown huge page mode: " << argv[i] << "\n";
+                return 1;
+            }
+            setHugePageMode(mode);
+        } else if (arg == "--cyclic") {
+            cyclic = true;
+        }
     }
-    long total_memory; std::vector<ParsedNodeSpec> specs; std::string error;
-    // Try examples format first
-    if (!parseExamplesFormat(fin, total_memory, specs, error)) {
-        fin.clear(); fin.seekg(0);
-        if (!parseSimpleFormat(fin, total_memory, specs, error)) {
-            std::cerr << "Parse error: " << error << "\n";
+    // Out-of-core mode: never materializes the Problem, writes the order to a file
+    if (!stream_output.empty()) {
+        StreamStats stats; std::string serr;
+        if (!streamSchedule(argv[1], stream_output, StreamOptions{}, stats, serr)) {
+            std::cerr << "Streaming failed: " << serr << "\n";
             return 2;
         }
+        std::cout << "Streamed " << stats.nodes << " nodes (" << stats.runs << " runs, " << stats.merge_passes << " merge passes, max resident "
+                  << stats.max_resident << ", " << stats.evictions << " evictions, " << stats.recomputes
+                  << " recomputes), order written to " << stream_output << "\n";
+        std::cout << "Total time: " << stats.total_time << "\n";
+        std::cout << "Memory peak: " << stats.memory_peak << " (limit=" << stats.total_memory << ")\n";
+        if (stats.memory_peak > stats.total_memory) {
+            std::cerr << "Streaming schedule exceeds the memory limit.\n";
+            return 3;
+        }
+        return 0;
     }
-    Problem prob = buildProblem(total_memory, specs);
-
-    // Adaptive parameters based on problem size
-    size_t num_nodes = prob.nodes.size();
-    size_t max_expansions;
-    double time_limit;
-    
-        ScheduleState result;
-    
-    // Set algorithm parameters based on problem size
-    if (num_nodes > 200000) {
-        // Ultra-massive problems: Set minimal parameters
-        std::cout << "Ultra-massive problem detected (" << num_nodes << " nodes)\n";
-        max_expansions = 10;
-        time_limit = 0.1;
-    } else if (num_nodes > 50000) {
-        // Very large problems: Conservative parameters
-        std::cout << "Very large problem detected (" << num_nodes << " nodes)\n";
-        max_expansions = 50;
-        time_limit = 0.2;
-    } else if (num_nodes > 10000) {
-        // Large problems: Fast parameters
-        std::cout << "Large problem detected (" << num_nodes << " nodes)\n";
-        max_expansions = std::min<size_t>(500, num_nodes / 100);
-        time_limit = 1.0;
-    } else if (num_nodes > 1000) {
-        // Medium problems: Moderate parameters
-        std::cout << "Medium problem detected (" << num_nodes << " nodes)\n";
-        max_expansions = std::min<size_t>(10000, num_nodes);
-        time_limit = 3.0;
-    } else {
-        // Small problems: Full parameters
-        std::cout << "Small problem detected (" << num_nodes << " nodes)\n";
-        max_expansions = 200000;
-        time_limit = 5.0;
+    Problem prob; std::string error;
+    if (!loadProblemFile(argv[1], prob, error)) {
+        std::cerr << "Parse error: " << error << "\n";
+        return 2;
+    }
+    // Op-type semantics (recompute multipliers, in-place, workspace) go into the cost model before anything reads it
+    if (!ops_path.empty()) {
+        OpRegistry ops;
+        if (!loadOpRegistry(ops_path, ops, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::cout << "Op registry: " << ops.size() << " types, " << applyOpRegistry(ops, prob) << " nodes adjusted\n";
+    }
+    // Memory hierarchy: tier 0 may override the budget, lower tiers hold outputs between uses
+    TierConfig tiers;
+    if (!tiers_path.empty()) {
+        if (!loadTierConfig(tiers_path, tiers, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        applyTierConfig(tiers, prob);
+    }
+    std::cout << "Graph storage: " << prob.bytesUsed() << " bytes ("
+              << (prob.size() ? prob.bytesUsed() / prob.size() : 0) << " bytes/node)\n";
+    if (hugePageMode() != HugePageMode::Off) {
+        HugePageStats hp = hugePageStats();
+        std::cout << "Huge pages (" << hugePageModeName(hugePageMode()) << "): " << hp.explicit_bytes << " bytes explicit, "
+                  << hp.transparent_bytes << " transparent, " << hp.plain_bytes << " plain, " << hp.fallbacks << " fallbacks\n";
     }
 
-    // Streamlined algorithm selection - remove complexity, focus on what works
-    
-    if (num_nodes > 100000) {
-        // Ultra-massive (examples 5,6,7): Use only the fastest possible algorithm
-        std::cout << "Ultra-massive problem - using immediate greedy (no complex algorithms)\n";
-        result = greedySchedule(prob);
-    } else if (num_nodes > 50) {
-        // Examples 2,3,4: Use the main algorithm that works
-        std::cout << "Using main algorithm (scheduleWithDebug)\n"; 
-        DebugOptions dbg{};
-        DebugStats stats{};
-        result = scheduleWithDebug(prob, max_expansions, time_limit, dbg, stats);
-    } else {
-        // Very small problems: Simple greedy
-        std::cout << "Small problem - using greedy\n";
-        result = greedySchedule(prob);
+    // O(N+E) bounds: a budget below the largest single-node need is rejected before any search
+    ScheduleBounds bounds = computeScheduleBounds(prob);
+    std::cout << "Lower bounds: peak >= " << bounds.peak << " (" << prob.name(bounds.peak_node) << "), time >= "
+              << bounds.time << " (forced recompute " << bounds.forced_recompute << ")\n";
+    if (!boundsFeasible(prob, bounds)) {
+        std::cerr << "Budget infeasible: " << prob.name(bounds.peak_node) << " alone needs " << bounds.peak
+                  << " > limit " << prob.total_memory << "\n";
+        return 3;
     }
-    
-    // Simple fallback: if main algorithm fails, try minimal alternatives
-    if (result.execution_order.size() != prob.nodes.size()) {
-        std::cout << "Main algorithm incomplete, trying heuristic...\n";
-        result = heuristicSchedule(prob);
+
+    // Pick scheduler and parameters from cheap graph features
+    GraphFeatures features = computeGraphFeatures(prob);
+    std::cout << "Graph features:";
+    for (int f = 0; f < GF_Count; ++f) std::cout << " " << graphFeatureName(f) << "=" << features.v[f];
+    std::cout << "\n";
+    StrategyChoice choice = selectStrategy(selector, features);
+    std::cout << "Selected strategy: " << describeStrategy(choice) << "\n";
+    // Simple fallback: if main algorithm fails or overshoots the budget, try minimal alternatives
+    auto fits = [](const Problem& p, const ScheduleState& s) {
+        return s.computed.count() == p.size() && s.memory_peak <= p.total_memory;
+    };
+    auto withFallbacks = [&](const Problem& p, ScheduleState result, bool log) {
+        if (fits(p, result)) return result;
+        if (log) std::cout << "Main algorithm incomplete or over budget, trying heuristic...\n";
+        result = heuristicSchedule(p);
         
-        if (result.execution_order.size() != prob.nodes.size()) {
-            std::cout << "Heuristic failed, trying greedy as final attempt...\n";  
-            result = greedySchedule(prob);
+        if (!fits(p, result)) {
+            if (log) std::cout << "Heuristic failed, trying priority rollout...\n";
+            result = prioritySchedule(p, weights);
         }
-        
-        if (result.execution_order.size() != prob.nodes.size()) {
+
+        if (!fits(p, result)) {
+            if (log) std::cout << "Priority rollout failed, trying greedy...\n";  
+            result = greedySchedule(p);
+        }
+
+        // Keep/recompute searches over a first-run order find fits the order-driven fallbacks
+        // miss, and often beat the one they did find: seed from it, else from the block schedule
+        ScheduleState seed;
+        if (fits(p, result)) {
+            if (log) std::cout << "Refining the fallback with tabu...\n";
+            seed = result;
+        } else {
+            if (log) std::cout << "Greedy failed, trying tabu over the block schedule...\n";
+            BlockOptions seedOpts;
+            seedOpts.relax_budget = true;
+            seed = blockReplicatedSchedule(p, seedOpts);
+        }
+        ScheduleState tabu = tabuSchedule(p, seed, TabuOptions{});
+        if (fits(p, tabu) && (!fits(p, result) || isBetterSchedule(tabu, result, p.total_memory))) result = tabu;
+        if (!fits(p, result)) {
+            if (log) std::cout << "Tabu failed, trying eager rematerialization as final attempt...\n";
+            result = eagerRematSchedule(p, seed, EagerRematOptions{});
+        }
+        return result;
+    };
+
+    // Repeated iterations: sources may stay resident across the boundary; reports the steady state
+    if (cyclic) {
+        CyclicStats cs;
+        // Each steady-state candidate gets the same fallbacks as a one-pass run, without the log
+        auto iteration = [&](const Problem& p) { return withFallbacks(p, runStrategy(p, choice, weights), false); };
+        ScheduleState steady = cyclicSchedule(prob, iteration, CyclicOptions{}, &cs);
+        std::cout << "Cyclic: carried " << cs.carried << " of " << cs.candidates << " sources (" << cs.carried_memory
+                  << " bytes), " << cs.probes << " probes\n";
+        std::cout << "Warm-up iteration: time " << cs.warmup_time << ", peak " << cs.warmup_peak << "\n";
+        std::cout << "Steady-state schedule (order):\n";
+        for (size_t i = 0; i < steady.execution_order.size(); ++i) {
+            if (i) std::cout << " -> ";
+            const ScheduleStep step = steady.execution_order[i];
+            std::cout << prob.name(step.node()) << (step.isRecompute() ? "*" : "");
+        }
+        std::cout << "\n* denotes recomputation\n";
+        std::cout << "Total time per iteration: " << cs.steady_time << "\n";
+        std::cout << "Memory peak: " << cs.steady_peak << " (limit=" << prob.total_memory << ")\n";
+        if (!cs.fits) {
+            std::cerr << "No steady-state schedule fits the memory limit.\n";
+            return 3;
+        }
+        return 0;
+    }
+    // Persistent schedule cache: per block shape for "blocks", the whole input otherwise (see runStrategy)
+    ScheduleCache cache;
+    if (!cache_path.empty()) {
+        std::string cache_err;
+        if (!cache.load(cache_path, cache_err)) {
+            std::cerr << cache_err << "\n";
+            return 1;
+        }
+    }
+    SearchReport report;
+    ScheduleState result = runStrategy(prob, choice, weights, cache_path.empty() ? nullptr : &cache, &report);
+
+    // Tuned priority rollout competes with the main algorithm when weights were supplied
+    if (have_weights) {
+        ScheduleState tuned = prioritySchedule(prob, weights);
+        bool tunedComplete = tuned.computed.count() == prob.size();
+        bool resultComplete = result.computed.count() == prob.size();
+        if (tunedComplete && (!resultComplete || isBetterSchedule(tuned, result, prob.total_memory))) {
+            std::cout << "Using tuned priority schedule\n";
+            result = tuned;
+            report.storage_events.clear();
+        }
+    }
+
+    if (!fits(prob, result)) {
+        report.storage_events.clear();
+        result = withFallbacks(prob, result, true);
+        if (!fits(prob, result)) {
             std::cerr << "No feasible schedule found.\n";
             return 3;
         }
     }
     
+    // Fallback results are remembered too, so the next run finds them without searching
+    if (!cache_path.empty()) {
+        // Storage transfers are not part of a cached order, so those results are not offered
+        if (result.memory_peak <= prob.total_memory && report.storage_events.empty()) cache.offer(blockHash(prob, 0, static_cast<uint32_t>(prob.size())), prob.total_memory, result);
+        std::cout << "Schedule cache: " << cache.hits() << " hits, " << cache.misses() << " misses, "
+                  << cache.size() << " entries\n";
+        std::string cache_err;
+        if (cache.dirty() && !cache.save(cache_path, cache_err)) std::cerr << cache_err << "\n";
+    }
+
+    // Placement across tiers over the result's first-run order, checked by an independent replay
+    if (!tiers_path.empty()) {
+        TierStats ts;
+        TieredSchedule tiered = tieredSchedule(prob, tiers, result, TierOptions{}, &ts);
+        if (!ts.fits) {
+            std::cerr << "No tier placement fits the memory limits.\n";
+            return 3;
+        }
+        std::string verr;
+        if (!validateTieredSchedule(prob, tiers, tiered, verr)) {
+            std::cerr << "Tiered schedule invalid: " << verr << "\n";
+            return 3;
+        }
+        std::cout << "Tiers: " << ts.demotions << " demotions, " << ts.promotions << " promotions, "
+                  << ts.recomputes << " recomputes, migration time " << ts.migration_time << "\n";
+        std::cout << "Schedule (order):\n";
+        size_t m = 0;
+        bool first = true;
+        auto item = [&](const std::string& s) { std::cout << (first ? "" : " -> ") << s; first = false; };
+        const std::vector<ScheduleStep>& steps = tiered.state.execution_order;
+        for (size_t i = 0; i <= steps.size(); ++i) {
+            for (; m < tiered.moves.size() && tiered.moves[m].step == i; ++m) {
+                const TierMove& mv = tiered.moves[m];
+                if (mv.kind == TierMoveKind::Demote) item(prob.name(mv.node) + ">" + tiers.tiers[mv.tier].name);
+                else if (mv.kind == TierMoveKind::Promote) item(prob.name(mv.node) + "<" + tiers.tiers[mv.tier].name);
+            }
+            if (i < steps.size()) item(prob.name(steps[i].node()) + (steps[i].isRecompute() ? "*" : ""));
+        }
+        std::cout << "\n* denotes recomputation, name>tier a demotion, name<tier a promotion\n";
+        std::cout << "Total time: " << tiered.state.total_time << "\n";
+        for (size_t t = 0; t < tiers.tiers.size(); ++t) {
+            long cap = t ? tiers.tiers[t].capacity : prob.total_memory;
+            std::cout << "Tier " << tiers.tiers[t].name << " peak: " << tiered.tier_peak[t] << " (limit=" << cap << ")\n";
+        }
+        return 0;
+    }
+
     std::cout << "Schedule (order):\n";
-    for (size_t i = 0; i < result.execution_order.size(); ++i) {
-        if (i) std::cout << " -> ";
-        const auto& name = result.execution_order[i];
-        bool rc = (i < result.recompute_flags.size()) ? result.recompute_flags[i] : false;
-        if (rc) std::cout << name << "*"; else std::cout << name;
+    const std::vector<StorageEvent>& events = report.storage_events;
+    size_t e = 0;
+    bool first = true;
+    auto item = [&](const std::string& s) { std::cout << (first ? "" : " -> ") << s; first = false; };
+    for (size_t i = 0; i <= result.execution_order.size(); ++i) {
+        for (; e < events.size() && events[e].step == i; ++e) {
+            static const char* const kMarks[] = {">zip", "<zip", ">host", "<host"}; // StorageEventKind order
+            item(prob.name(events[e].node) + kMarks[static_cast<int>(events[e].kind)]);
+        }
+        if (i < result.execution_order.size()) {
+            const ScheduleStep step = result.execution_order[i];
+            item(prob.name(step.node()) + (step.isRecompute() ? "*" : ""));
+        }
     }
-    std::cout << "\n* denotes recomputation\n";
+    std::cout << "\n* denotes recomputation";
+    if (!events.empty()) std::cout << ", name>zip / name<zip an encode / decode, name>host / name<host an offload / restore";
+    std::cout << "\n";
     std::cout << "Total time: " << result.total_time << "\n";
     std::cout << "Memory peak: " << result.memory_peak << " (limit=" << prob.total_memory << ")\n";
+    // Distance to the bounds; a search that proved a tighter time bound (astar, cp) supersedes the static one
+    long timeBound = std::max(bounds.time, report.lower_bound);
+    std::cout << "Gap to lower bounds: time " << result.total_time - timeBound << " ("
+              << (result.total_time > 0 ? 100.0 * static_cast<double>(result.total_time - timeBound) / static_cast<double>(result.total_time) : 0.0)
+              << "%), peak " << result.memory_peak - bounds.peak << "\n";
     return 0;
 }
 
@@ -0,0 +1,48 @@
+#include "model.hpp"
+
+uint32_t NameTable::intern(const std::string& stem) {
+    auto it = stem_index_.find(stem);
+    if (it != stem_index_.end()) return it->second;
+    uint32_t idx = static_cast<uint32_t>(stems_.size());
+    stems_.push_back(stem);
+    stem_index_.emplace(stem, idx);
+    return idx;
+}
+
+void NameTable::add(const std::string& stem, uint32_t id_suffix) {
+    stem_of_.push_back(intern(stem));
+    suffix_.push_back(id_suffix);
+}
+
+void NameTable::add(const std::string& name) {
+    // Split only when "<stem>_id<n>" round-trips exactly (no leading zeros, at most 9 digits)
+    auto pos = name.rfind("_id");
+    if (pos != std::string::npos) {
+        std::string digits = name.substr(pos + 3);
+        bool numeric = !digits.empty() && digits.size() <= 9 &&
+                       digits.find_first_not_of("0123456789") == std::string::npos &&
+                       (digits[0] != '0' || digits.size() == 1);
+        if (numeric) { add(name.substr(0, pos), static_cast<uint32_t>(std::stoul(digits))); return; }
+    }
+    add(name, kNoSuffix);
+}
+
+std::string NameTable::name(NodeId id) const {
+    const std::string& stem = stems_[stem_of_[id]];
+    if (suffix_[id] == kNoSuffix) return stem;
+    return stem + "_id" + std::to_string(suffix_[id]);
+}
+
+size_t NameTable::bytesUsed() const {
+    size_t bytes = stem_of_.capacity() * sizeof(uint32_t) + suffix_.capacity() * sizeof(uint32_t);
+    for (const auto& s : stems_) bytes += 2 * (sizeof(std::string) + s.capacity()) + 2 * sizeof(void*);
+    return bytes;
+}
+
+size_t Problem::bytesUsed() const {
+    return nodes.capacity() * sizeof(Node) + names.bytesUsed() +
+           (input_offsets.capacity() + consumer_offsets.capacity()) * sizeof(uint32_t) +
+           (input_ids.capacity() + consumer_ids.capacity()) * sizeof(NodeId) +
+           recompute_cost.capacity() * sizeof(int) + in_place.words().capacity() * sizeof(uint64_t) +
+           storage.capacity() * sizeof(StorageCosts);
+}
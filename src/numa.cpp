@@ -0,0 +1,75 @@
+#include "numa.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+static std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+        try {
+            auto dash = range.find('-');
+            int lo = std::stoi(range.substr(0, dash));
+            int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+            for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        } catch (...) { return {}; }
+    }
+    return cpus;
+}
+
+NumaTopology detectNumaTopology() {
+    NumaTopology topo;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) { topo.node_cpus.emplace_back(); return topo; }
+    // Node ids may have gaps (offline or memory-only nodes); stop after a run of missing ones
+    for (int node = 0, missing = 0; missing < 64; ++node) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) { ++missing; continue; }
+        missing = 0;
+        std::string line;
+        std::getline(in, line);
+        std::vector<int> cpus;
+        for (int c : parseCpuList(line)) {
+            if (c >= 0 && c < CPU_SETSIZE && CPU_ISSET(c, &allowed)) cpus.push_back(c);
+        }
+        if (!cpus.empty()) topo.node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    if (topo.node_cpus.empty()) topo.node_cpus.emplace_back();
+    return topo;
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+ProblemReplicas::ProblemReplicas(const Problem& prob, const NumaTopology& topo) : prob_(prob) {
+    if (!topo.multiNode()) return;
+    copies_.resize(topo.nodes());
+    std::vector<std::thread> builders;
+    for (size_t node = 0; node < topo.nodes(); ++node) {
+        builders.emplace_back([&, node] {
+            pinCurrentThread(topo.node_cpus[node]);
+            copies_[node].reset(new Problem(prob));
+        });
+    }
+    for (auto& th : builders) th.join();
+}
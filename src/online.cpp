@@ -0,0 +1,144 @@
+#include "online.hpp"
+#include <algorithm>
+
+OnlineScheduler::OnlineScheduler(long total_memory, const OnlineOptions& opts, Sink sink)
+    : total_memory_(total_memory), opts_(opts), sink_(std::move(sink)) {}
+
+bool OnlineScheduler::push(const ParsedNodeSpec& spec, std::string& error) {
+    if (ids_.count(spec.name)) { error = "Duplicate node '" + spec.name + "'"; return false; }
+    const size_t firstInput = input_ids_.size();
+    for (const auto& in : spec.inputs) {
+        auto it = ids_.find(in);
+        if (it == ids_.end()) {
+            input_ids_.resize(firstInput);
+            error = "Input '" + in + "' of '" + spec.name + "' has not arrived";
+            return false;
+        }
+        if (std::find(input_ids_.begin() + static_cast<std::ptrdiff_t>(firstInput), input_ids_.end(), it->second) == input_ids_.end()) {
+            input_ids_.push_back(it->second);
+        }
+    }
+    const NodeId id = static_cast<NodeId>(nodes_.size());
+    ids_.emplace(spec.name, id);
+    names_.add(spec.name);
+    nodes_.emplace_back(spec.run_mem, spec.output_mem, spec.time_cost);
+    input_offsets_.push_back(static_cast<uint32_t>(input_ids_.size()));
+    window_uses_.push_back(0);
+    pins_.push_back(0);
+    computed_.push_back(0);
+    list_.push_back(kNone);
+    prev_.push_back(kNoNode);
+    next_.push_back(kNoNode);
+    ++stats_.nodes;
+
+    // A read inside the window makes the output warm and recent
+    for (size_t k = firstInput; k < input_ids_.size(); ++k) {
+        NodeId x = input_ids_[k];
+        if (window_uses_[x]++ == 0 && list_[x] == kCold) { unlink(x); link(x, kWarm); }
+        else touch(x);
+    }
+    window_.push_back(id);
+    if (window_.size() > std::max<size_t>(opts_.lookahead, 1)) runOldest();
+    return true;
+}
+
+void OnlineScheduler::finish() {
+    while (!window_.empty()) runOldest();
+    while (cold_.head != kNoNode) release(cold_.head, OnlineActionKind::Free);
+    while (warm_.head != kNoNode) release(warm_.head, OnlineActionKind::Free);
+}
+
+void OnlineScheduler::runOldest() {
+    NodeId v = window_.front();
+    window_.pop_front();
+    materialize(v);
+    for (uint32_t k = input_offsets_[v]; k < input_offsets_[v + 1]; ++k) {
+        NodeId x = input_ids_[k];
+        if (--window_uses_[x] == 0 && list_[x] == kWarm) { unlink(x); link(x, kCold); }
+    }
+}
+
+// Runs `v` after recomputing whatever it reads that was evicted, depth first. Inputs of every
+// node on the stack are pinned so making room for one recompute cannot evict another's input.
+void OnlineScheduler::materialize(NodeId v) {
+    auto pin = [&](NodeId y, bool on) {
+        for (uint32_t k = input_offsets_[y]; k < input_offsets_[y + 1]; ++k) {
+            if (on) ++pins_[input_ids_[k]]; else --pins_[input_ids_[k]];
+        }
+    };
+    stack_.assign(1, v);
+    pin(v, true);
+    while (!stack_.empty()) {
+        NodeId y = stack_.back();
+        if (y != v && list_[y] != kNone) { stack_.pop_back(); pin(y, false); continue; } // restored meanwhile
+        bool ready = true;
+        for (uint32_t k = input_offsets_[y]; k < input_offsets_[y + 1]; ++k) {
+            NodeId x = input_ids_[k];
+            if (list_[x] == kNone) { stack_.push_back(x); pin(x, true); ready = false; }
+        }
+        if (!ready) continue;
+        stack_.pop_back();
+        runNode(y);
+        pin(y, false);
+    }
+}
+
+void OnlineScheduler::runNode(NodeId id) {
+    const Node& node = nodes_[id];
+    while (current_ + node.getPeak() > total_memory_) {
+        if (!evictOne(cold_) && !evictOne(warm_)) { ++stats_.over_budget; break; }
+    }
+    stats_.memory_peak = std::max(stats_.memory_peak, current_ + node.getPeak());
+    stats_.total_time += node.getTimeCost();
+    bool again = computed_[id] != 0;
+    computed_[id] = 1;
+    if (again) ++stats_.recomputes; else ++stats_.runs;
+    emit(again ? OnlineActionKind::Recompute : OnlineActionKind::Run, id);
+    if (list_[id] == kNone) {
+        current_ += node.getOutputMem();
+        link(id, window_uses_[id] > 0 ? kWarm : kCold);
+    }
+    for (uint32_t k = input_offsets_[id]; k < input_offsets_[id + 1]; ++k) touch(input_ids_[k]);
+}
+
+// Least recently used unpinned output of `chain`; pinned ones are in use, so they move to the back
+bool OnlineScheduler::evictOne(Chain& chain) {
+    for (size_t tries = chain.size; tries > 0 && chain.head != kNoNode; --tries) {
+        NodeId h = chain.head;
+        if (pins_[h] == 0) { release(h, OnlineActionKind::Spill); return true; }
+        touch(h);
+    }
+    return false;
+}
+
+void OnlineScheduler::release(NodeId id, OnlineActionKind kind) {
+    unlink(id);
+    current_ -= nodes_[id].getOutputMem();
+    if (kind == OnlineActionKind::Spill) ++stats_.spills; else ++stats_.frees;
+    emit(kind, id);
+}
+
+void OnlineScheduler::link(NodeId id, List list) {
+    Chain& c = chain(list);
+    list_[id] = list;
+    prev_[id] = c.tail;
+    next_[id] = kNoNode;
+    if (c.tail != kNoNode) next_[c.tail] = id; else c.head = id;
+    c.tail = id;
+    ++c.size;
+}
+
+void OnlineScheduler::unlink(NodeId id) {
+    Chain& c = chain(static_cast<List>(list_[id]));
+    if (prev_[id] != kNoNode) next_[prev_[id]] = next_[id]; else c.head = next_[id];
+    if (next_[id] != kNoNode) prev_[next_[id]] = prev_[id]; else c.tail = prev_[id];
+    --c.size;
+    list_[id] = kNone;
+}
+
+void OnlineScheduler::touch(NodeId id) {
+    if (list_[id] == kNone) return;
+    List list = static_cast<List>(list_[id]);
+    unlink(id);
+    link(id, list);
+}
@@ -0,0 +1,120 @@
+#include "op_registry.hpp"
+#include "blocks.hpp"
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+static bool applyTrait(OpTraits& t, const std::string& kv) {
+    auto eq = kv.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = kv.substr(0, eq), val = kv.substr(eq + 1);
+    try {
+        if (key == "recompute") t.recompute = std::stod(val);
+        else if (key == "in_place") t.in_place = std::stoi(val) != 0;
+        else if (key == "workspace") t.workspace = std::stod(val);
+        else if (key == "workspace_min") t.workspace_min = std::stol(val);
+        else if (key == "offload") t.offload = std::stod(val);
+        else if (key == "transfer") t.transfer = std::stod(val);
+        else if (key == "compress") t.compress = std::stod(val);
+        else if (key == "encode") t.encode = std::stod(val);
+        else if (key == "decode") t.decode = std::stod(val);
+        else return false;
+    } catch (...) { return false; }
+    return t.recompute >= 0.0 && t.workspace >= 0.0 && t.workspace_min >= 0 && t.offload >= 0.0 && t.offload <= 1.0 &&
+           t.transfer >= 0.0 && t.compress >= 0.0 && t.compress < 1.0 && t.encode >= 0.0 && t.decode >= 0.0;
+}
+
+bool OpRegistry::load(std::istream& in, std::string& error) {
+    OpTraits defaults;
+    std::vector<std::pair<std::string, std::vector<std::string>>> lines;
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::stringstream ss(line);
+        std::string type;
+        if (!(ss >> type)) continue;
+        std::vector<std::string> kvs;
+        for (std::string t; ss >> t;) kvs.push_back(t);
+        for (const auto& kv : kvs) {
+            OpTraits probe;
+            if (!applyTrait(probe, kv)) { error = "Invalid trait '" + kv + "' on line " + std::to_string(line_no); return false; }
+        }
+        if (type == "*") for (const auto& kv : kvs) applyTrait(defaults, kv);
+        else lines.emplace_back(type, std::move(kvs));
+    }
+    // Listed types start from the defaults wherever the '*' line appears
+    std::unordered_map<std::string, OpTraits> types;
+    for (const auto& l : lines) {
+        auto it = types.emplace(l.first, defaults).first;
+        for (const auto& kv : l.second) applyTrait(it->second, kv);
+    }
+    defaults_ = defaults;
+    types_ = std::move(types);
+    return true;
+}
+
+const OpTraits& OpRegistry::traits(const std::string& type) const {
+    auto it = types_.find(type);
+    return it == types_.end() ? defaults_ : it->second;
+}
+
+bool loadOpRegistry(const std::string& path, OpRegistry& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) { error = "Failed to open op registry: " + path; return false; }
+    OpRegistry reg;
+    if (!reg.load(in, error)) { error += " in " + path; return false; }
+    out = std::move(reg);
+    return true;
+}
+
+static int clampCost(double v) {
+    return static_cast<int>(std::min<double>(INT_MAX, std::max(0.0, std::round(v))));
+}
+
+size_t applyOpRegistry(const OpRegistry& reg, Problem& prob) {
+    std::unordered_map<const std::string*, const OpTraits*> byStem; // a few hundred stems per graph
+    std::vector<int> recompute(prob.size());
+    NodeBitset inPlace;
+    std::vector<StorageCosts> storage(prob.size());
+    bool scaled = false, stored = false;
+    size_t changed = 0;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        const std::string& stem = prob.names.stem(id);
+        auto it = byStem.find(&stem);
+        if (it == byStem.end()) it = byStem.emplace(&stem, &reg.traits(opType(stem))).first;
+        const OpTraits& t = *it->second;
+        const Node& n = prob.nodes[id];
+        long workspace = std::max(t.workspace_min, static_cast<long>(std::ceil(t.workspace * n.getOutputMem())));
+        recompute[id] = clampCost(t.recompute * n.getTimeCost());
+        scaled |= recompute[id] != n.getTimeCost();
+        // In-place needs an input to overwrite
+        bool inPlaceHere = t.in_place && !prob.inputs(id).empty();
+        if (inPlaceHere) inPlace.set(id);
+        if (workspace > 0) {
+            prob.nodes[id] = Node(clampCost(static_cast<double>(n.getRunMem()) + workspace), n.getOutputMem(), n.getTimeCost());
+        }
+        // Storage costs scale with output_mem, in MiB
+        const double mib = n.getOutputMem() / 1048576.0;
+        StorageCosts& sc = storage[id];
+        if (t.compress > 0.0) {
+            sc.compressed_mem = clampCost(std::ceil(t.compress * n.getOutputMem()));
+            sc.encode_time = clampCost(t.encode * mib);
+            sc.decode_time = clampCost(t.decode * mib);
+        }
+        if (t.offload > 0.0) sc.transfer_time = clampCost(t.transfer * mib / t.offload);
+        bool storable = sc.compressed_mem >= 0 || sc.transfer_time >= 0;
+        stored |= storable;
+        if (workspace > 0 || recompute[id] != n.getTimeCost() || inPlaceHere || storable) ++changed;
+    }
+    if (scaled) prob.recompute_cost = std::move(recompute);
+    else prob.recompute_cost.clear();
+    prob.in_place = std::move(inPlace);
+    if (stored) prob.storage = std::move(storage);
+    else prob.storage.clear();
+    return changed;
+}
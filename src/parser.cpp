@@ -1,4 +1,6 @@
 #include "parser.hpp"
+#include <algorithm>
+#include <fstream>
 #include <sstream>
 #include <unordered_set>
 
@@ -140,16 +142,202 @@ bool parseExamplesFormat(std::istream& in, long& total_memory,
 }
 
 Problem buildProblem(long total_memory, const std::vector<ParsedNodeSpec>& specs) {
-    Problem prob; prob.total_memory = total_memory;
+    std::unordered_map<std::string, NodeId> ids;
+    ids.reserve(specs.size());
+    std::vector<const ParsedNodeSpec*> unique;
+    unique.reserve(specs.size());
     for (const auto& s : specs) {
-        prob.nodes.emplace(s.name, Node(s.name, s.inputs, s.run_mem, s.output_mem, s.time_cost));
+        if (ids.emplace(s.name, static_cast<NodeId>(unique.size())).second) unique.push_back(&s);
     }
-    for (const auto& s : specs) {
-        for (const auto& input : s.inputs) {
-            prob.dependencies[input].insert(s.name);
-            prob.successors[input].push_back(s.name);
+    ProblemBuilder builder(total_memory);
+    builder.reserve(unique.size(), 0);
+    for (const ParsedNodeSpec* s : unique) {
+        builder.addNode(s->name, s->run_mem, s->output_mem, s->time_cost);
+        for (const auto& input : s->inputs) {
+            auto it = ids.find(input);
+            if (it != ids.end()) builder.addInput(it->second);
+        }
+    }
+    return builder.finish();
+}
+
+void ProblemBuilder::reserve(size_t nodes, size_t edges) {
+    prob_.nodes.reserve(nodes);
+    prob_.names.reserve(nodes);
+    prob_.input_offsets.reserve(nodes + 1);
+    prob_.input_ids.reserve(edges);
+}
+
+NodeId ProblemBuilder::addNode(const std::string& name, int run_mem, int output_mem, int time_cost) {
+    prob_.names.add(name);
+    prob_.nodes.emplace_back(run_mem, output_mem, time_cost);
+    prob_.input_offsets.push_back(static_cast<uint32_t>(prob_.input_ids.size()));
+    return static_cast<NodeId>(prob_.nodes.size() - 1);
+}
+
+NodeId ProblemBuilder::addNode(const std::string& stem, uint32_t id_suffix, int run_mem, int output_mem, int time_cost) {
+    prob_.names.add(stem, id_suffix);
+    prob_.nodes.emplace_back(run_mem, output_mem, time_cost);
+    prob_.input_offsets.push_back(static_cast<uint32_t>(prob_.input_ids.size()));
+    return static_cast<NodeId>(prob_.nodes.size() - 1);
+}
+
+void ProblemBuilder::addInput(NodeId input) {
+    // A repeated input would also repeat the consumer entry and count its output twice
+    auto row = prob_.input_ids.begin() + prob_.input_offsets[prob_.input_offsets.size() - 2];
+    if (std::find(row, prob_.input_ids.end(), input) != prob_.input_ids.end()) return;
+    prob_.input_ids.push_back(input);
+    prob_.input_offsets.back() = static_cast<uint32_t>(prob_.input_ids.size());
+}
+
+void ProblemBuilder::addLateInput(NodeId consumer, NodeId input) {
+    late_inputs_.emplace_back(consumer, input);
+}
+
+Problem ProblemBuilder::finish() {
+    Problem& p = prob_;
+    const size_t n = p.nodes.size();
+    // Merge late inputs and drop dangling ids in one rebuild of the input rows
+    bool dangling = std::any_of(p.input_ids.begin(), p.input_ids.end(), [n](NodeId id) { return id >= n; });
+    if (!late_inputs_.empty() || dangling) {
+        HugeVector<uint32_t> count(n + 1, 0);
+        for (NodeId v = 0; v < n; ++v) {
+            for (uint32_t k = p.input_offsets[v]; k < p.input_offsets[v + 1]; ++k) if (p.input_ids[k] < n) ++count[v + 1];
         }
-        prob.successors[s.name];
+        for (const auto& e : late_inputs_) if (e.first < n && e.second < n) ++count[e.first + 1];
+        for (size_t v = 0; v < n; ++v) count[v + 1] += count[v];
+        HugeVector<NodeId> ids(count[n]);
+        std::vector<uint32_t> fill(count.begin(), count.end() - 1);
+        for (NodeId v = 0; v < n; ++v) {
+            for (uint32_t k = p.input_offsets[v]; k < p.input_offsets[v + 1]; ++k) if (p.input_ids[k] < n) ids[fill[v]++] = p.input_ids[k];
+        }
+        for (const auto& e : late_inputs_) if (e.first < n && e.second < n) ids[fill[e.first]++] = e.second;
+        p.input_offsets.swap(count);
+        p.input_ids.swap(ids);
+        late_inputs_.clear();
+    }
+    // Consumers are the transpose of the input rows (counting sort keeps consumers in id order)
+    p.consumer_offsets.assign(n + 1, 0);
+    for (NodeId in : p.input_ids) ++p.consumer_offsets[in + 1];
+    for (size_t v = 0; v < n; ++v) p.consumer_offsets[v + 1] += p.consumer_offsets[v];
+    p.consumer_ids.resize(p.input_ids.size());
+    std::vector<uint32_t> fill(p.consumer_offsets.begin(), p.consumer_offsets.end() - 1);
+    for (NodeId v = 0; v < n; ++v) {
+        for (NodeId in : p.inputs(v)) p.consumer_ids[fill[in]++] = v;
+    }
+    p.input_ids.shrink_to_fit();
+    p.nodes.shrink_to_fit();
+    return std::move(prob_);
+}
+
+static std::string tooManyNodes() {
+    return "More than " + std::to_string(ScheduleStep::kMaxNodes) + " nodes; schedule steps hold 31-bit node ids";
+}
+
+bool parseExamplesHeader(const std::string& line, long& total_memory) {
+    std::stringstream hs(line);
+    std::string ret;
+    return (hs >> ret >> total_memory) && ret == "Return";
+}
+
+bool parseExamplesRow(const std::string& line, ExamplesRow& row) {
+    std::stringstream ss(line);
+    int num_inputs = 0;
+    if (!(ss >> row.id >> row.name >> num_inputs)) return false;
+    row.inputs.clear();
+    for (int i = 0; i < num_inputs; ++i) {
+        long iid = -1; if (!(ss >> iid)) { iid = -1; } row.inputs.push_back(iid);
     }
-    return prob;
+    long ws = 0, outm = 0, t = 0;
+    ss >> ws; ss >> outm; ss >> t;
+    row.run_mem = std::max<long>(ws, 0);
+    row.output_mem = std::max<long>(outm, 0);
+    row.time_cost = std::max<long>(t, 0);
+    return true;
+}
+
+bool loadExamplesProblem(std::istream& in, Problem& out, std::string& error) {
+    std::string line;
+    long total_memory = -1;
+    if (!std::getline(in, line)) { error = "Empty file"; return false; }
+    if (!parseExamplesHeader(line, total_memory)) {
+        error = "Expected 'Return <total_memory>' header";
+        return false;
+    }
+
+    // File ids -> NodeIds: dense vector for the usual 0..N-1 numbering, map for outliers
+    const NodeId kNone = 0xFFFFFFFFu;
+    std::vector<NodeId> dense;
+    std::unordered_map<long, NodeId> sparse;
+    auto lookup = [&](long fid) -> NodeId {
+        if (fid >= 0 && static_cast<size_t>(fid) < dense.size()) return dense[static_cast<size_t>(fid)];
+        auto it = sparse.find(fid);
+        return it != sparse.end() ? it->second : kNone;
+    };
+
+    ProblemBuilder builder(total_memory);
+    ExamplesRow row;
+    std::vector<std::pair<NodeId, long>> forward;
+    while (std::getline(in, line)) {
+        if (!parseExamplesRow(line, row)) continue;
+        const long fid = row.id;
+        if (fid < 0 || fid >= static_cast<long>(NameTable::kNoSuffix)) {
+            error = "Node id " + std::to_string(fid) + " out of range";
+            return false;
+        }
+        if (lookup(fid) != kNone) continue; // duplicate id: the first definition wins
+        if (builder.size() >= ScheduleStep::kMaxNodes) { error = tooManyNodes(); return false; }
+        NodeId nid = builder.addNode(row.name, static_cast<uint32_t>(fid), static_cast<int>(row.run_mem),
+                                     static_cast<int>(row.output_mem), static_cast<int>(row.time_cost));
+        if (fid >= 0 && static_cast<size_t>(fid) <= 4 * builder.size() + 1024) {
+            if (dense.size() <= static_cast<size_t>(fid)) dense.resize(std::max<size_t>(static_cast<size_t>(fid) + 1, dense.size() * 2), kNone);
+            dense[static_cast<size_t>(fid)] = nid;
+        } else {
+            sparse.emplace(fid, nid);
+        }
+        for (size_t k = 0; k < row.inputs.size(); ++k) {
+            const long iid = row.inputs[k];
+            if (iid < 0 || std::find(row.inputs.begin(), row.inputs.begin() + static_cast<std::ptrdiff_t>(k), iid) !=
+                               row.inputs.begin() + static_cast<std::ptrdiff_t>(k)) continue;
+            NodeId src = lookup(iid);
+            if (src != kNone) builder.addInput(src); else forward.emplace_back(nid, iid);
+        }
+    }
+    for (const auto& f : forward) {
+        NodeId src = lookup(f.second);
+        if (src != kNone) builder.addLateInput(f.first, src);
+    }
+    if (builder.size() == 0) { error = "No nodes parsed"; return false; }
+    out = builder.finish();
+    return true;
+}
+
+bool loadProblemFile(const std::string& path, Problem& out, std::string& error) {
+    std::ifstream fin(path);
+    if (!fin) { error = "Failed to open input: " + path; return false; }
+    // A "Return" header settles the format, so examples-format errors are reported as such
+    std::string first;
+    long total_memory;
+    std::getline(fin, first);
+    fin.clear(); fin.seekg(0);
+    if (parseExamplesHeader(first, total_memory)) return loadExamplesProblem(fin, out, error);
+    std::vector<ParsedNodeSpec> specs;
+    if (!parseSimpleFormat(fin, total_memory, specs, error)) return false;
+    if (specs.size() > ScheduleStep::kMaxNodes) { error = tooManyNodes(); return false; }
+    out = buildProblem(total_memory, specs);
+    return true;
+}
+
+bool saveExamplesProblem(const std::string& path, const Problem& prob, std::string& error) {
+    std::ofstream out(path);
+    if (!out) { error = "Failed to write graph file: " + path; return false; }
+    out << "Return " << prob.total_memory << "\n";
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        const Node& n = prob.nodes[id];
+        out << id << " " << prob.names.stem(id) << " " << prob.inputs(id).size();
+        for (NodeId in : prob.inputs(id)) out << " " << in;
+        out << " " << n.getRunMem() << " " << n.getOutputMem() << " " << n.getTimeCost() << "\n";
+    }
+    if (!out) { error = "Failed to write graph file: " + path; return false; }
+    return true;
 }
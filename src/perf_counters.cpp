@@ -0,0 +1,88 @@
+#include "perf_counters.hpp"
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* perfEventName(int event) {
+    static const char* const kNames[PE_Count] = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+    return event >= 0 && event < PE_Count ? kNames[event] : "?";
+}
+
+#ifdef __linux__
+
+static int openEvent(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;        // threads created while counting
+    attr.exclude_kernel = 1; // allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+PerfCounters::PerfCounters() {
+    const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const std::pair<uint32_t, uint64_t> events[PE_Count] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, l1dReadMiss},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}, // last-level cache on most PMUs
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    for (int e = 0; e < PE_Count; ++e) {
+        fd_[e] = openEvent(events[e].first, events[e].second);
+        if (fd_[e] < 0 && error_.empty()) error_ = std::string(perfEventName(e)) + ": " + std::strerror(errno);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fd_) if (fd >= 0) close(fd);
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fd_) if (fd >= 0) return true;
+    return false;
+}
+
+void PerfCounters::start() {
+    for (int fd : fd_) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample s;
+    for (int e = 0; e < PE_Count; ++e) {
+        if (fd_[e] < 0) continue;
+        ioctl(fd_[e], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t buf[3] = {0, 0, 0}; // value, time enabled, time running
+        if (read(fd_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)) || buf[2] == 0) continue;
+        s.value[e] = static_cast<double>(buf[0]) * static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+        s.valid[e] = true;
+    }
+    return s;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("perf_event_open is Linux-only") {
+    for (int& fd : fd_) fd = -1;
+}
+PerfCounters::~PerfCounters() {}
+bool PerfCounters::available() const { return false; }
+void PerfCounters::start() {}
+PerfSample PerfCounters::stop() { return PerfSample{}; }
+
+#endif
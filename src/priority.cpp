@@ -0,0 +1,60 @@
+#include "priority.hpp"
+#include <fstream>
+#include <sstream>
+
+static const char* const kFeatureNames[PF_Count] = {
+    "dynamic_impact",
+    "predicted_peak",
+    "time_cost",
+    "output_mem",
+    "run_mem",
+    "fan_in",
+    "fan_out",
+};
+
+const char* priorityFeatureName(int feature) {
+    if (feature < 0 || feature >= PF_Count) return "";
+    return kFeatureNames[feature];
+}
+
+PriorityWeights defaultPriorityWeights() {
+    PriorityWeights pw;
+    pw.w[PF_DynamicImpact] = 4.0;
+    pw.w[PF_PredictedPeak] = 1.0;
+    pw.w[PF_TimeCost] = 0.01;
+    return pw;
+}
+
+bool loadPriorityWeights(const std::string& path, PriorityWeights& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) { error = "Failed to open weight file: " + path; return false; }
+    PriorityWeights pw = defaultPriorityWeights();
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::stringstream ss(line);
+        std::string key; double value = 0.0;
+        if (!(ss >> key)) continue;
+        if (!(ss >> value)) { error = "Missing value on line " + std::to_string(line_no); return false; }
+        int feature = -1;
+        for (int f = 0; f < PF_Count; ++f) {
+            if (key == kFeatureNames[f]) { feature = f; break; }
+        }
+        if (feature < 0) { error = "Unknown feature '" + key + "' on line " + std::to_string(line_no); return false; }
+        pw.w[feature] = value;
+    }
+    out = pw;
+    return true;
+}
+
+bool savePriorityWeights(const std::string& path, const PriorityWeights& weights, std::string& error) {
+    std::ofstream out(path);
+    if (!out) { error = "Failed to write weight file: " + path; return false; }
+    out.precision(9);
+    out << "# prioritySchedule weights (lower score runs first)\n";
+    for (int f = 0; f < PF_Count; ++f) out << kFeatureNames[f] << " " << weights.w[f] << "\n";
+    return static_cast<bool>(out);
+}
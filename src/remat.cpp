@@ -0,0 +1,74 @@
+#include "remat.hpp"
+#include "tabu.hpp"
+#include <algorithm>
+#include <functional>
+
+double rematRatio(const Problem& prob, NodeId id) {
+    if (prob.consumers(id).empty()) return 0.0;
+    return static_cast<double>(prob.nodes[id].getOutputMem()) / static_cast<double>(std::max(1, prob.recomputeCost(id)));
+}
+
+NodeBitset cheapOutputs(const Problem& prob, double threshold) {
+    NodeBitset out;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        double r = rematRatio(prob, id);
+        if (r > 0.0 && r >= threshold) out.set(id);
+    }
+    return out;
+}
+
+ScheduleState eagerRematSchedule(const Problem& prob, const ScheduleState& seed, const EagerRematOptions& opts,
+                                 EagerRematStats* stats, NodeBitset* dropped) {
+    EagerRematStats local;
+    EagerRematStats& st = stats ? *stats : local;
+    st = EagerRematStats{};
+    const std::vector<NodeId> order = firstRunOrder(prob, seed);
+    auto finish = [&](ScheduleState s, double threshold, NodeBitset drop) {
+        st.threshold = threshold;
+        st.dropped = drop.count();
+        st.fits = s.computed.count() == prob.size() && s.memory_peak <= prob.total_memory;
+        if (dropped) *dropped = std::move(drop);
+        return s;
+    };
+    if (opts.threshold > 0.0) {
+        NodeBitset drop = cheapOutputs(prob, opts.threshold);
+        st.probes = 1;
+        return finish(decodeDrops(prob, order, drop), opts.threshold, std::move(drop));
+    }
+
+    // Distinct ratios, highest first; dropping the top k tends to lower the peak as k grows
+    std::vector<double> ratios;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        double r = rematRatio(prob, id);
+        if (r > 0.0) ratios.push_back(r);
+    }
+    std::sort(ratios.begin(), ratios.end(), std::greater<double>());
+    ratios.erase(std::unique(ratios.begin(), ratios.end()), ratios.end());
+
+    ScheduleState best = decodeDrops(prob, order, NodeBitset{});
+    double bestThreshold = ratios.empty() ? 0.0 : ratios.front() * 2.0; // drops nothing
+    NodeBitset bestDrop;
+    st.probes = 1;
+    if (best.memory_peak <= prob.total_memory || ratios.empty()) return finish(std::move(best), bestThreshold, bestDrop);
+    bool bestFits = false;
+    size_t lo = 0, hi = ratios.size() - 1; // smallest index whose threshold fits
+    while (lo <= hi && st.probes < std::max<size_t>(2, opts.max_probes)) {
+        size_t mid = lo + (hi - lo) / 2;
+        NodeBitset drop = cheapOutputs(prob, ratios[mid]);
+        ScheduleState s = decodeDrops(prob, order, drop);
+        ++st.probes;
+        bool complete = s.computed.count() == prob.size();
+        bool fits = complete && s.memory_peak <= prob.total_memory;
+        // Among fitting probes the highest threshold wins (fewest recomputations)
+        if ((fits && (!bestFits || ratios[mid] > bestThreshold)) ||
+            (!fits && !bestFits && complete && s.memory_peak < best.memory_peak)) {
+            best = std::move(s);
+            bestThreshold = ratios[mid];
+            bestDrop = std::move(drop);
+            bestFits = fits;
+        }
+        if (fits) { if (mid == 0) break; hi = mid - 1; }
+        else lo = mid + 1;
+    }
+    return finish(std::move(best), bestThreshold, std::move(bestDrop));
+}
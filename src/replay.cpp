@@ -0,0 +1,413 @@
+#include "parser.hpp"
+#include "selector.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Replays a schedule with real host buffers: every output gets a buffer from its run until the
+// step it is released at (releasePoints), and run_mem beyond output_mem is a workspace held for
+// the step alone. Sizes are divided by --scale. Buffers are touched one byte per page (outputs
+// and workspaces written, inputs read), so resident memory tracks the schedule. Per allocator it
+// reports peak RSS above the starting RSS, time spent inside allocate/free (for the static plan,
+// planning included), and fragmentation: 1 - peak live bytes / peak allocator footprint.
+
+namespace {
+
+struct ReplayOptions {
+    std::string input;
+    std::string selector;
+    std::string allocator{"all"}; // glibc | arena | static | all
+    size_t scale{1024};
+    bool touch{true};
+};
+
+const size_t kPage = 4096;
+volatile long g_readSink = 0; // keeps the simulated reads
+
+// Allocation events in execution order: step p allocates, touches, then frees
+struct Trace {
+    std::vector<size_t> buffers; // sizes
+    std::vector<uint32_t> allocs, frees, reads; // buffer ids
+    std::vector<size_t> allocOff{0}, freeOff{0}, readOff{0}; // per step
+    size_t peak_live{0};
+};
+
+bool buildTrace(const Problem& prob, const std::vector<ScheduleStep>& order, size_t scale, Trace& t, std::string& error) {
+    const uint32_t kNoBuffer = 0xFFFFFFFFu;
+    std::vector<uint32_t> live(prob.size(), kNoBuffer);
+    const auto drops = releasePoints(prob, order);
+    auto scaled = [&](long bytes) { return bytes <= 0 ? size_t{0} : (static_cast<size_t>(bytes) + scale - 1) / scale; };
+    auto add = [&](size_t bytes) {
+        t.buffers.push_back(bytes);
+        t.allocs.push_back(static_cast<uint32_t>(t.buffers.size() - 1));
+        return static_cast<uint32_t>(t.buffers.size() - 1);
+    };
+    size_t d = 0, liveBytes = 0;
+    for (size_t p = 0; p < order.size(); ++p) {
+        const NodeId v = order[p].node();
+        const Node& n = prob.nodes[v];
+        for (NodeId x : prob.inputs(v)) {
+            if (prob.nodes[x].getOutputMem() > 0 && live[x] == kNoBuffer) {
+                error = "Step " + std::to_string(p) + " reads " + prob.name(x) + ", which is not resident";
+                return false;
+            }
+            if (live[x] != kNoBuffer) t.reads.push_back(live[x]);
+        }
+        uint32_t ws = kNoBuffer;
+        if (n.getRunMem() > n.getOutputMem()) ws = add(scaled(n.getRunMem() - n.getOutputMem()));
+        if (n.getOutputMem() > 0 && live[v] == kNoBuffer) live[v] = add(scaled(n.getOutputMem()));
+        for (size_t k = t.allocOff.back(); k < t.allocs.size(); ++k) liveBytes += t.buffers[t.allocs[k]];
+        t.peak_live = std::max(t.peak_live, liveBytes);
+        if (ws != kNoBuffer) { t.frees.push_back(ws); liveBytes -= t.buffers[ws]; }
+        for (; d < drops.size() && drops[d].first == p; ++d) {
+            uint32_t& b = live[drops[d].second];
+            if (b == kNoBuffer) continue;
+            t.frees.push_back(b);
+            liveBytes -= t.buffers[b];
+            b = kNoBuffer;
+        }
+        t.allocOff.push_back(t.allocs.size());
+        t.freeOff.push_back(t.frees.size());
+        t.readOff.push_back(t.reads.size());
+    }
+    // Outputs still held at the end are released after the last step
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        if (live[id] == kNoBuffer) continue;
+        t.frees.push_back(live[id]);
+    }
+    if (!order.empty()) t.freeOff.back() = t.frees.size();
+    return true;
+}
+
+// Resident set size in bytes from /proc/self/statm, or 0 where it is unavailable
+size_t residentBytes() {
+    std::ifstream in("/proc/self/statm");
+    size_t total = 0, resident = 0;
+    if (!(in >> total >> resident)) return 0;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void* mapRegion(size_t bytes) {
+    if (bytes == 0) return nullptr;
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// glibc malloc/free; footprint is what the heap holds from the system (brk arena plus mmapped
+// chunks) beyond what it held just before the first allocation, since the heap is process-wide
+class GlibcAllocator {
+public:
+    const char* name() const { return "glibc"; }
+    void* allocate(size_t bytes) {
+        if (base_ < 0) base_ = heapBytes();
+        return std::malloc(bytes);
+    }
+    void release(void* p, size_t) { std::free(p); }
+    long footprint() const {
+        long now = heapBytes();
+        if (now < 0) return -1;
+        return base_ < 0 || now < base_ ? 0 : now - base_;
+    }
+
+private:
+    static long heapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 mi = mallinfo2();
+        return static_cast<long>(mi.arena + mi.hblkhd);
+#else
+        return -1;
+#endif
+    }
+
+    long base_{-1}; // heap bytes before the first allocation
+};
+
+// Caching arena, as device runtimes use: sizes round up to a power of two (at least a page),
+// freed blocks wait on a per-class list for the next request of that class, new blocks are
+// carved from one reserved region and nothing is returned until the arena is destroyed.
+class ArenaAllocator {
+public:
+    explicit ArenaAllocator(size_t capacity) : capacity_(capacity), base_(static_cast<char*>(mapRegion(capacity))) {}
+    ~ArenaAllocator() { if (base_) munmap(base_, capacity_); }
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+    const char* name() const { return "arena"; }
+    void* allocate(size_t bytes) {
+        size_t c = sizeClass(bytes);
+        if (c < free_.size() && !free_[c].empty()) {
+            void* p = free_[c].back();
+            free_[c].pop_back();
+            return p;
+        }
+        size_t size = size_t{1} << c;
+        if (!base_ || top_ + size > capacity_) return nullptr;
+        void* p = base_ + top_;
+        top_ += size;
+        return p;
+    }
+    void release(void* p, size_t bytes) {
+        size_t c = sizeClass(bytes);
+        if (c >= free_.size()) free_.resize(c + 1);
+        free_[c].push_back(p);
+    }
+    long footprint() const { return static_cast<long>(top_); }
+private:
+    static size_t sizeClass(size_t bytes) {
+        size_t c = 12;
+        while ((size_t{1} << c) < bytes) ++c;
+        return c;
+    }
+    size_t capacity_;
+    char* base_;
+    size_t top_{0};
+    std::vector<std::vector<void*>> free_;
+};
+
+// Offsets planned before execution from the known lifetimes: buffers are placed in allocation
+// order at the best-fitting gap among the buffers live at that point (address-ordered free map),
+// so at run time an allocation is an array lookup.
+class StaticPlan {
+public:
+    explicit StaticPlan(const Trace& t) : offset_(t.buffers.size()) {
+        std::map<size_t, size_t> gaps;              // offset -> length, coalesced, below size_
+        std::set<std::pair<size_t, size_t>> bySize; // (length, offset) of the same gaps
+        auto drop = [&](std::map<size_t, size_t>::iterator it) {
+            bySize.erase({it->second, it->first});
+            return gaps.erase(it);
+        };
+        auto keep = [&](size_t at, size_t len) { gaps.emplace(at, len); bySize.emplace(len, at); };
+        auto take = [&](size_t bytes) {
+            auto best = bySize.lower_bound({bytes, 0});
+            if (best == bySize.end()) {
+                // Grow at the end, absorbing a trailing gap
+                size_t at = size_;
+                if (!gaps.empty() && std::prev(gaps.end())->first + std::prev(gaps.end())->second == size_) {
+                    at = std::prev(gaps.end())->first;
+                    drop(std::prev(gaps.end()));
+                }
+                size_ = std::max(size_, at + bytes);
+                return at;
+            }
+            size_t len = best->first, at = best->second;
+            drop(gaps.find(at));
+            if (len > bytes) keep(at + bytes, len - bytes);
+            return at;
+        };
+        auto give = [&](size_t at, size_t bytes) {
+            auto next = gaps.lower_bound(at);
+            if (next != gaps.end() && at + bytes == next->first) { bytes += next->second; next = drop(next); }
+            if (next != gaps.begin()) {
+                auto prev = std::prev(next);
+                if (prev->first + prev->second == at) { at = prev->first; bytes += prev->second; drop(prev); }
+            }
+            keep(at, bytes);
+        };
+        auto t0 = std::chrono::steady_clock::now();
+        const size_t steps = t.allocOff.size() - 1;
+        for (size_t p = 0; p < steps; ++p) {
+            for (size_t k = t.allocOff[p]; k < t.allocOff[p + 1]; ++k) {
+                uint32_t b = t.allocs[k];
+                if (t.buffers[b] > 0) offset_[b] = take(roundUp(t.buffers[b]));
+            }
+            for (size_t k = t.freeOff[p]; k < t.freeOff[p + 1]; ++k) {
+                uint32_t b = t.frees[k];
+                if (t.buffers[b] > 0) give(offset_[b], roundUp(t.buffers[b]));
+            }
+        }
+        plan_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        base_ = static_cast<char*>(mapRegion(size_));
+    }
+    ~StaticPlan() { if (base_) munmap(base_, size_); }
+    StaticPlan(const StaticPlan&) = delete;
+    StaticPlan& operator=(const StaticPlan&) = delete;
+    const char* name() const { return "static"; }
+    void* at(uint32_t buffer) const { return base_ ? base_ + offset_[buffer] : nullptr; }
+    long footprint() const { return static_cast<long>(size_); }
+    double planSeconds() const { return plan_seconds_; }
+private:
+    static size_t roundUp(size_t bytes) { return (bytes + 63) / 64 * 64; }
+    std::vector<size_t> offset_;
+    size_t size_{0};
+    char* base_{nullptr};
+    double plan_seconds_{0.0};
+};
+
+struct ReplayResult {
+    size_t rss_peak{0};
+    double alloc_seconds{0.0};
+    double wall_seconds{0.0};
+    long footprint_peak{-1};
+    size_t failures{0};
+};
+
+void touchWrite(void* p, size_t bytes) {
+    char* c = static_cast<char*>(p);
+    for (size_t i = 0; i < bytes; i += kPage) c[i] = 1;
+    if (bytes) c[bytes - 1] = 1;
+}
+
+long touchRead(const void* p, size_t bytes) {
+    const volatile char* c = static_cast<const volatile char*>(p);
+    long sum = 0;
+    for (size_t i = 0; i < bytes; i += kPage) sum += c[i];
+    return sum;
+}
+
+// Drives one allocator through the trace. `get` returns the buffer's address after the
+// allocator handed it out; `put` gives it back.
+template <typename Get, typename Put, typename Footprint>
+ReplayResult replayTrace(const Trace& t, bool touch, Get get, Put put, Footprint footprint) {
+    ReplayResult r;
+    std::vector<void*> ptr(t.buffers.size(), nullptr);
+#if defined(__GLIBC__)
+    malloc_trim(0); // heap freed by earlier runs would otherwise be reused below the baseline
+#endif
+    const size_t base = residentBytes();
+    auto t0 = std::chrono::steady_clock::now();
+    const size_t steps = t.allocOff.size() - 1;
+    for (size_t p = 0; p < steps; ++p) {
+        auto a0 = std::chrono::steady_clock::now();
+        for (size_t k = t.allocOff[p]; k < t.allocOff[p + 1]; ++k) {
+            uint32_t b = t.allocs[k];
+            if (t.buffers[b] == 0) continue;
+            ptr[b] = get(b);
+            if (!ptr[b]) ++r.failures;
+        }
+        r.alloc_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - a0).count();
+        r.footprint_peak = std::max(r.footprint_peak, footprint());
+        if (touch) {
+            for (size_t k = t.readOff[p]; k < t.readOff[p + 1]; ++k) {
+                uint32_t b = t.reads[k];
+                if (ptr[b]) g_readSink += touchRead(ptr[b], t.buffers[b]);
+            }
+            for (size_t k = t.allocOff[p]; k < t.allocOff[p + 1]; ++k) {
+                uint32_t b = t.allocs[k];
+                if (ptr[b]) touchWrite(ptr[b], t.buffers[b]);
+            }
+        }
+        r.rss_peak = std::max(r.rss_peak, residentBytes());
+        auto f0 = std::chrono::steady_clock::now();
+        for (size_t k = t.freeOff[p]; k < t.freeOff[p + 1]; ++k) {
+            uint32_t b = t.frees[k];
+            if (ptr[b]) put(b, ptr[b]);
+            ptr[b] = nullptr;
+        }
+        r.alloc_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - f0).count();
+    }
+    r.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    r.rss_peak = r.rss_peak > base ? r.rss_peak - base : 0;
+    return r;
+}
+
+void report(const char* name, const Trace& t, const ReplayResult& r, double extra_seconds) {
+    double frag = r.footprint_peak > 0 ? 1.0 - static_cast<double>(t.peak_live) / static_cast<double>(r.footprint_peak) : -1.0;
+    std::cout << std::left << std::setw(8) << name << std::right
+              << std::setw(14) << r.rss_peak
+              << std::setw(14) << r.footprint_peak
+              << std::setw(12) << std::fixed << std::setprecision(3) << (r.alloc_seconds + extra_seconds) * 1000.0
+              << std::setw(12) << r.wall_seconds * 1000.0
+              << std::setw(10) << std::setprecision(4);
+    if (frag >= 0) std::cout << frag; else std::cout << "-";
+    std::cout << std::setw(10) << r.failures << "\n";
+    std::cout.unsetf(std::ios::fixed);
+}
+
+bool parseArgs(int argc, char** argv, ReplayOptions& opts) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string a = argv[i];
+            auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+            const char* v = nullptr;
+            if (a == "--selector" && (v = value())) opts.selector = v;
+            else if (a == "--allocator" && (v = value())) opts.allocator = v;
+            else if (a == "--scale" && (v = value())) opts.scale = std::max<size_t>(1, std::stoul(v));
+            else if (a == "--no-touch") opts.touch = false;
+            else if (!a.empty() && a[0] == '-') return false;
+            else if (opts.input.empty()) opts.input = a;
+            else return false;
+        }
+    } catch (const std::exception&) {
+        return false; // malformed number
+    }
+    return !opts.input.empty() &&
+           (opts.allocator == "all" || opts.allocator == "glibc" || opts.allocator == "arena" || opts.allocator == "static");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ReplayOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::cout << "Usage: replay <input_file> [--selector rules.txt] [--allocator glibc|arena|static|all] "
+                     "[--scale N] [--no-touch]\n";
+        return 0;
+    }
+    Problem prob; std::string error;
+    if (!loadProblemFile(opts.input, prob, error)) {
+        std::cerr << "Parse error: " << error << "\n";
+        return 2;
+    }
+    StrategySelector selector = defaultStrategySelector();
+    if (!opts.selector.empty() && !loadStrategySelector(opts.selector, selector, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    StrategyChoice choice = selectStrategy(selector, computeGraphFeatures(prob));
+    ScheduleState s = runStrategy(prob, choice, defaultPriorityWeights());
+    // Same fallbacks as scheduler
+    std::string used = describeStrategy(choice);
+    if (s.computed.count() != prob.size()) { s = heuristicSchedule(prob); used = "heuristic (fallback)"; }
+    if (s.computed.count() != prob.size()) { s = prioritySchedule(prob, defaultPriorityWeights()); used = "priority (fallback)"; }
+    if (s.computed.count() != prob.size()) { s = greedySchedule(prob); used = "greedy (fallback)"; }
+    if (s.computed.count() != prob.size()) {
+        std::cerr << "No complete schedule to replay.\n";
+        return 3;
+    }
+    Trace t;
+    if (!buildTrace(prob, s.execution_order, opts.scale, t, error)) {
+        std::cerr << error << "\n";
+        return 3;
+    }
+    std::cout << "Schedule: " << used << ", " << s.execution_order.size() << " steps, peak "
+              << s.memory_peak << " (limit=" << prob.total_memory << ")\n";
+    std::cout << "Replay: " << t.buffers.size() << " buffers, scale 1/" << opts.scale << ", peak live "
+              << t.peak_live << " bytes (model peak / scale = " << s.memory_peak / static_cast<long>(opts.scale) << ")\n";
+    std::cout << std::left << std::setw(8) << "alloc" << std::right << std::setw(14) << "rss_peak" << std::setw(14) << "footprint"
+              << std::setw(12) << "alloc_ms" << std::setw(12) << "wall_ms" << std::setw(10) << "frag" << std::setw(10) << "failed" << "\n";
+
+    // The regions of arena and static are unmapped before glibc runs, so each starts from the same RSS
+    if (opts.allocator == "all" || opts.allocator == "static") {
+        StaticPlan plan(t);
+        ReplayResult r = replayTrace(t, opts.touch, [&](uint32_t b) { return plan.at(b); }, [](uint32_t, void*) {},
+                                     [&]() { return plan.footprint(); });
+        report(plan.name(), t, r, plan.planSeconds());
+    }
+    if (opts.allocator == "all" || opts.allocator == "arena") {
+        // Power-of-two rounding at most doubles each buffer; twice the live peak plus slack covers the cache
+        ArenaAllocator arena(4 * t.peak_live + (size_t{64} << 20));
+        ReplayResult r = replayTrace(t, opts.touch, [&](uint32_t b) { return arena.allocate(t.buffers[b]); },
+                                     [&](uint32_t b, void* p) { arena.release(p, t.buffers[b]); },
+                                     [&]() { return arena.footprint(); });
+        report(arena.name(), t, r, 0.0);
+    }
+    if (opts.allocator == "all" || opts.allocator == "glibc") {
+        GlibcAllocator glibc;
+        ReplayResult r = replayTrace(t, opts.touch, [&](uint32_t b) { return glibc.allocate(t.buffers[b]); },
+                                     [&](uint32_t b, void* p) { glibc.release(p, t.buffers[b]); },
+                                     [&]() { return glibc.footprint(); });
+        report(glibc.name(), t, r, 0.0);
+    }
+    return 0;
+}
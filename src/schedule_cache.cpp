@@ -0,0 +1,101 @@
+#include "schedule_cache.hpp"
+#include "scheduler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+// File format: one entry per line, "<hash hex> <budget> <peak> <total_time> <step>...", where a step is
+// a region-local node index with a trailing '*' for recomputation; '#' starts a comment.
+bool ScheduleCache::load(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) return true;
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::stringstream ss(line);
+        std::string key;
+        if (!(ss >> key)) continue;
+        Entry e;
+        uint64_t h = 0;
+        try { h = std::stoull(key, nullptr, 16); } catch (...) {
+            error = "Invalid hash on line " + std::to_string(line_no);
+            return false;
+        }
+        if (!(ss >> e.budget >> e.peak >> e.total_time)) { error = "Missing budget/peak/time on line " + std::to_string(line_no); return false; }
+        std::string step;
+        while (ss >> step) {
+            bool recompute = !step.empty() && step.back() == '*';
+            if (recompute) step.pop_back();
+            try { e.steps.emplace_back(static_cast<NodeId>(std::stoul(step)), recompute); } catch (...) {
+                error = "Invalid step '" + step + "' on line " + std::to_string(line_no);
+                return false;
+            }
+        }
+        entries_[h].push_back(std::move(e));
+    }
+    return true;
+}
+
+bool ScheduleCache::save(const std::string& path, std::string& error) const {
+    // Written next to the target and renamed over it, so an interrupted save keeps the old file
+    const std::string tmp = path + ".tmp";
+    std::ofstream out(tmp);
+    if (!out) { error = "Failed to write schedule cache: " + tmp; return false; }
+    out << "# subgraph schedule cache: <hash> <budget> <peak> <total_time> <steps, * = recompute>\n";
+    for (const auto& kv : entries_) {
+        for (const Entry& e : kv.second) {
+            out << std::hex << kv.first << std::dec << " " << e.budget << " " << e.peak << " " << e.total_time;
+            for (const ScheduleStep& st : e.steps) out << " " << st.node() << (st.isRecompute() ? "*" : "");
+            out << "\n";
+        }
+    }
+    out.close();
+    if (!out || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        error = "Failed to write schedule cache: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool ScheduleCache::lookup(uint64_t hash, const Problem& region, long budget, ScheduleState& out) const {
+    auto it = entries_.find(hash);
+    bool found = false;
+    if (it != entries_.end()) {
+        for (const Entry& e : it->second) {
+            if (e.budget < budget || e.peak > budget) continue;
+            bool inRange = true;
+            for (const ScheduleStep& st : e.steps) if (st.node() >= region.size()) { inRange = false; break; }
+            if (!inRange) continue;
+            // Timings may differ between occurrences, so rank by a replay on this region
+            ScheduleState s = replaySchedule(region, e.steps);
+            if (s.computed.count() != region.size() || s.memory_peak > budget) continue;
+            if (!found || s.total_time < out.total_time) { out = std::move(s); found = true; }
+        }
+    }
+    ++(found ? hits_ : misses_);
+    return found;
+}
+
+bool ScheduleCache::offer(uint64_t hash, long budget, const ScheduleState& s) {
+    auto& list = entries_[hash];
+    for (const Entry& e : list) {
+        if (e.budget >= budget && e.peak <= s.memory_peak && e.total_time <= s.total_time) return false;
+    }
+    list.erase(std::remove_if(list.begin(), list.end(), [&](const Entry& e) {
+        return e.budget <= budget && e.peak >= s.memory_peak && e.total_time >= s.total_time;
+    }), list.end());
+    list.push_back({budget, s.memory_peak, s.total_time, s.execution_order});
+    dirty_ = true;
+    return true;
+}
+
+size_t ScheduleCache::size() const {
+    size_t n = 0;
+    for (const auto& kv : entries_) n += kv.second.size();
+    return n;
+}
@@ -1,31 +1,49 @@
 #include "scheduler.hpp"
+#include "transposition.hpp"
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <algorithm>
-#include <map>
-#include <set>
+#include <limits>
 #include <queue>
+#include <set>
 
 // Memoization cache for avoiding recomputation of equivalent states
 struct StateHash {
-    size_t operator()(const std::unordered_set<std::string>& computed) const {
+    size_t operator()(const std::vector<uint64_t>& computed) const {
         size_t hash = 0;
-        for (const auto& name : computed) {
-            hash ^= std::hash<std::string>{}(name) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        for (uint64_t word : computed) {
+            hash ^= std::hash<uint64_t>{}(word) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
         }
         return hash;
     }
 };
 
-// Cache for memoization - maps computed nodes set to best known result
-static thread_local std::unordered_map<std::unordered_set<std::string>, std::pair<int, int>, StateHash> memo_cache;
+// Cache for memoization - maps computed node set (bitset words) to best known result
+// alongside the sleep set of the visit that explored it: moves in that set were not tried there
+struct MemoEntry {
+    long total_time;
+    long memory_peak;
+    std::vector<NodeId> sleep;
+};
+static thread_local std::unordered_map<std::vector<uint64_t>, MemoEntry, StateHash> memo_cache;
 
 // Bring in implementations from the previous reference file
 // Only include what's necessary here
 
-int calculateSequentialPeak(const ScheduleState& state, const Node& node_B, int impact_A) {
-    int peak_B = node_B.getPeak();
-    return std::max(state.memory_peak, peak_B + impact_A);
+long calculateSequentialPeak(const Problem& prob, NodeId id, const ScheduleState& state) {
+    return std::max(state.memory_peak, stepPeak(prob, id, state));
+}
+
+double relativeScheduleCost(const Problem& prob, const ScheduleState& s) {
+    long ideal = 0;
+    for (const auto& node : prob.nodes) ideal += node.getTimeCost();
+    if (ideal <= 0) ideal = 1;
+    if (s.computed.count() != prob.size() || s.memory_peak > prob.total_memory) {
+        double done = prob.nodes.empty() ? 1.0 : static_cast<double>(s.computed.count()) / prob.size();
+        return 10.0 + (1.0 - done);
+    }
+    return static_cast<double>(s.total_time) / static_cast<double>(ideal);
 }
 
 bool isBetterSchedule(const ScheduleState& state1, const ScheduleState& state2, long total_memory) {
@@ -38,415 +56,475 @@ bool isBetterSchedule(const ScheduleState& state1, const ScheduleState& state2,
     return state1.memory_peak < state2.memory_peak;
 }
 
-std::unordered_set<std::string> getFreeableInputs(
-    const Node& node,
-    const ScheduleState& state,
-    const std::unordered_map<std::string, std::unordered_set<std::string>>& dependencies) {
-    std::unordered_set<std::string> freeable;
-    for (const auto& input_name : node.getInputs()) {
-        auto dep_it = dependencies.find(input_name);
-        if (dep_it == dependencies.end()) { freeable.insert(input_name); continue; }
-        bool all_consumers_done = true;
-        for (const auto& consumer : dep_it->second) {
-            if (state.computed.find(consumer) == state.computed.end()) { all_consumers_done = false; break; }
+// An input can be released once every consumer has run; `running` counts as done.
+static bool allConsumersDone(const Problem& prob, NodeId input, const ScheduleState& state, NodeId running) {
+    for (NodeId consumer : prob.consumers(input)) {
+        if (consumer != running && !state.computed.test(consumer)) return false;
+    }
+    return true;
+}
+
+std::vector<NodeId> getFreeableInputs(const Problem& prob, NodeId node, const ScheduleState& state) {
+    std::vector<NodeId> freeable;
+    for (NodeId input : prob.inputs(node)) {
+        if (allConsumersDone(prob, input, state, node) &&
+            std::find(freeable.begin(), freeable.end(), input) == freeable.end()) {
+            freeable.push_back(input);
         }
-        if (all_consumers_done) freeable.insert(input_name);
     }
     return freeable;
 }
 
-std::vector<std::string> getReadyNodeNames(const Problem& prob, const ScheduleState& state) {
-    std::vector<std::string> ready;
-    ready.reserve(prob.nodes.size());
-    for (const auto& kv : prob.nodes) {
-        const std::string& name = kv.first;
-        if (state.computed.count(name)) continue; // do not schedule original run again here
-        const Node& n = kv.second;
-        bool ok = true;
-        for (const auto& inName : n.getInputs()) {
-            // Require the input output to be currently available in memory
-            if (state.output_memory.find(inName) == state.output_memory.end()) { ok = false; break; }
-        }
-        if (ok) ready.push_back(name);
+static bool inputsResident(const Problem& prob, NodeId id, const ScheduleState& state) {
+    for (NodeId input : prob.inputs(id)) {
+        if (!state.resident.test(input)) return false;
+    }
+    return true;
+}
+
+// Any consumer of `id` still waiting for its first run
+bool hasPendingConsumer(const Problem& prob, NodeId id, const ScheduleState& state) {
+    for (NodeId consumer : prob.consumers(id)) {
+        if (!state.computed.test(consumer)) return true;
+    }
+    return false;
+}
+
+std::vector<NodeId> getReadyNodes(const Problem& prob, const ScheduleState& state) {
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        if (state.computed.test(id)) continue; // do not schedule original run again here
+        // Require the input output to be currently available in memory
+        if (inputsResident(prob, id, state)) ready.push_back(id);
     }
     return ready;
 }
 
-static int calculateDynamicImpact(
-    const Node& node,
-    const ScheduleState& state,
-    const std::unordered_map<std::string, std::unordered_set<std::string>>& dependencies,
-    const std::unordered_map<std::string, int>& output_memory) {
-    ScheduleState postState = state;
-    postState.computed.insert(node.getName());
-    auto freeable = getFreeableInputs(node, postState, dependencies);
+long calculateDynamicImpact(const Problem& prob, NodeId id, const ScheduleState& state) {
     long freed = 0;
-    for (const auto& input_name : freeable) {
-        auto it = output_memory.find(input_name);
-        if (it != output_memory.end()) freed += it->second;
+    for (NodeId input : getFreeableInputs(prob, id, state)) {
+        if (state.resident.test(input)) freed += prob.nodes[input].getOutputMem();
     }
-    long impact = static_cast<long>(node.getOutputMem()) - freed;
-    if (impact < 0) return static_cast<int>(impact);
-    if (impact > std::numeric_limits<int>::max()) impact = std::numeric_limits<int>::max();
-    return static_cast<int>(impact);
+    return static_cast<long>(prob.nodes[id].getOutputMem()) - freed;
 }
 
-ScheduleState executeNode(
-    const std::string& node_name,
-    const Problem& prob,
-    const ScheduleState& state) {
-    ScheduleState next = state;
-    const Node& node = prob.nodes.at(node_name);
-    int predicted_peak = calculateSequentialPeak(state, node, state.current_memory);
-    next.memory_peak = std::max(state.memory_peak, predicted_peak);
-    
-    // Optimize freeable computation by avoiding extra ScheduleState copy
-    std::unordered_set<std::string> freeable;
-    for (const auto& input_name : node.getInputs()) {
-        auto dep_it = prob.dependencies.find(input_name);
-        if (dep_it == prob.dependencies.end()) { 
-            freeable.insert(input_name); 
-            continue; 
-        }
-        bool all_consumers_done = true;
-        for (const auto& consumer : dep_it->second) {
-            if (state.computed.find(consumer) == state.computed.end() && consumer != node_name) { 
-                all_consumers_done = false; 
-                break; 
-            }
+long stepPeak(const Problem& prob, NodeId id, const ScheduleState& state) {
+    const Node& node = prob.nodes[id];
+    long out = node.getOutputMem();
+    if (prob.in_place.test(id)) {
+        NodeId first = *prob.inputs(id).begin();
+        if (state.resident.test(first) && allConsumersDone(prob, first, state, id)) {
+            out -= std::min<long>(out, prob.nodes[first].getOutputMem());
         }
-        if (all_consumers_done) freeable.insert(input_name);
     }
-    
+    return state.current_memory + std::max<long>(node.getRunMem(), out);
+}
+
+// Runs `id` on `state` in place; executeNode is the copying form used by the searches.
+void applyNode(NodeId id, const Problem& prob, ScheduleState& state) {
+    const Node& node = prob.nodes[id];
+    state.memory_peak = std::max(state.memory_peak, stepPeak(prob, id, state));
+
     long freed = 0;
-    for (const auto& nm : freeable) {
-        auto it = next.output_memory.find(nm);
-        if (it != next.output_memory.end()) { 
-            freed += it->second; 
-            next.output_memory.erase(it); 
-        }
-    }
-    
-    long impact = static_cast<long>(node.getOutputMem()) - freed;
-    long new_current = static_cast<long>(next.current_memory) + impact;
-    if (new_current < 0) new_current = 0;
-    next.current_memory = static_cast<int>(new_current);
-    next.total_time += node.getTimeCost();
-    next.output_memory[node.getName()] = node.getOutputMem();
-    next.execution_order.push_back(node.getName());
-    
+    for (NodeId input : prob.inputs(id)) {
+        if (state.resident.test(input) && allConsumersDone(prob, input, state, id)) {
+            freed += prob.nodes[input].getOutputMem();
+            state.resident.reset(input);
+        }
+    }
+
     // recompute flag: true if this node was already computed before and we are running again to restore its output
-    bool isRecompute = (state.computed.count(node.getName()) > 0);
-    next.recompute_flags.push_back(isRecompute);
-    next.computed.insert(node.getName());
+    bool isRecompute = state.computed.test(id);
+    state.current_memory = std::max(0L, state.current_memory + node.getOutputMem() - freed);
+    state.total_time += isRecompute ? prob.recomputeCost(id) : node.getTimeCost();
+    state.resident.set(id);
+
+    state.execution_order.emplace_back(id, isRecompute);
+    state.computed.set(id);
+}
+
+ScheduleState executeNode(NodeId id, const Problem& prob, const ScheduleState& state) {
+    ScheduleState next = state;
+    applyNode(id, prob, next);
     return next;
 }
 
-static std::vector<std::string> pruneReadyListDynamic(
-    const std::vector<std::string>& ready_names,
+static std::vector<NodeId> pruneReadyListDynamic(
+    const std::vector<NodeId>& ready,
     const Problem& prob,
     const ScheduleState& state) {
-    const Node* best_negative = nullptr;
-    std::string best_name;
-    int min_negative_peak = std::numeric_limits<int>::max();
-    for (const auto& nm : ready_names) {
-        const Node& node = prob.nodes.at(nm);
-        int dynImpact = calculateDynamicImpact(node, state, prob.dependencies, state.output_memory);
-        if (dynImpact <= 0 && node.getPeak() < min_negative_peak) {
-            best_negative = &node; best_name = nm; min_negative_peak = node.getPeak();
+    bool found = false;
+    NodeId best_negative = 0;
+    long min_negative_peak = std::numeric_limits<long>::max();
+    for (NodeId id : ready) {
+        long dynImpact = calculateDynamicImpact(prob, id, state);
+        if (dynImpact <= 0 && prob.nodes[id].getPeak() < min_negative_peak) {
+            found = true; best_negative = id; min_negative_peak = prob.nodes[id].getPeak();
         }
     }
-    if (best_negative == nullptr) return ready_names;
-    int predicted_peak = calculateSequentialPeak(state, *best_negative, state.current_memory);
-    if (predicted_peak <= state.memory_peak) return {best_name};
-    std::vector<std::string> pruned;
-    for (const auto& nm : ready_names) {
-        const Node& node = prob.nodes.at(nm);
-        if (&node == best_negative || node.getPeak() < min_negative_peak) pruned.push_back(nm);
+    if (!found) return ready;
+    long predicted_peak = calculateSequentialPeak(prob, best_negative, state);
+    if (predicted_peak <= state.memory_peak) return {best_negative};
+    std::vector<NodeId> pruned;
+    for (NodeId id : ready) {
+        if (id == best_negative || prob.nodes[id].getPeak() < min_negative_peak) pruned.push_back(id);
     }
-    return pruned.empty() ? ready_names : pruned;
+    return pruned.empty() ? ready : pruned;
 }
 
 // Recompute candidates: nodes whose output is currently missing but needed by some uncomputed consumer,
 // and whose inputs are available in memory now. We allow recomputing even if they ran before.
-static std::vector<std::string> getRecomputeCandidates(const Problem& prob, const ScheduleState& state) {
-    std::vector<std::string> cands;
-    cands.reserve(prob.nodes.size());
-    for (const auto& kv : prob.nodes) {
-        const std::string& name = kv.first;
+std::vector<NodeId> getRecomputeCandidates(const Problem& prob, const ScheduleState& state) {
+    std::vector<NodeId> cands;
+    for (NodeId id = 0; id < prob.size(); ++id) {
         // Skip if output already available
-        if (state.output_memory.find(name) != state.output_memory.end()) continue;
+        if (state.resident.test(id)) continue;
         // Must have at least one consumer not yet computed
-        auto itSucc = prob.successors.find(name);
-        bool needed = false;
-        if (itSucc != prob.successors.end()) {
-            for (const auto& cons : itSucc->second) {
-                if (state.computed.find(cons) == state.computed.end()) { needed = true; break; }
-            }
-        }
-        if (!needed) continue;
+        if (!hasPendingConsumer(prob, id, state)) continue;
         // Inputs for this node must be available to recompute now
-        const Node& n = kv.second;
-        bool inputsAvail = true;
-        for (const auto& inName : n.getInputs()) {
-            if (state.output_memory.find(inName) == state.output_memory.end()) { inputsAvail = false; break; }
-        }
-        if (!inputsAvail) continue;
-        cands.push_back(name);
+        if (!inputsResident(prob, id, state)) continue;
+        cands.push_back(id);
     }
     return cands;
 }
 
+void spillOutput(const Problem& prob, ScheduleState& state, NodeId id) {
+    state.resident.reset(id);
+    state.current_memory = std::max(0L, state.current_memory - prob.nodes[id].getOutputMem());
+}
+
 // Spill: remove the largest resident output to reduce current memory
-static bool trySpillLargest(ScheduleState& state) {
-    if (state.output_memory.empty()) return false;
-    auto it = std::max_element(state.output_memory.begin(), state.output_memory.end(),
-                               [](const auto& a, const auto& b){ return a.second < b.second; });
-    if (it == state.output_memory.end()) return false;
-    int sz = it->second;
-    state.output_memory.erase(it);
-    state.current_memory = std::max(0, state.current_memory - sz);
+static bool trySpillLargest(const Problem& prob, ScheduleState& state) {
+    bool found = false; NodeId best = 0; int bestSize = -1;
+    state.resident.forEach([&](NodeId id) {
+        if (prob.nodes[id].getOutputMem() > bestSize) { found = true; best = id; bestSize = prob.nodes[id].getOutputMem(); }
+    });
+    if (!found) return false;
+    spillOutput(prob, state, best);
     return true;
 }
 
-// Spill with heuristic: pick resident output maximizing (size / (recompute_time+1)) and with remaining consumers
+// Spill with heuristic: pick resident output maximizing (size / (recompute_time+1)) and with remaining consumers.
+// Outputs nobody needs anymore are dropped for free along the way.
 static bool trySpillBest(const Problem& prob, ScheduleState& state) {
-    std::string best; double bestScore = -1.0; int bestSize = 0;
-    for (const auto& kv : state.output_memory) {
-        const std::string& name = kv.first; int sz = kv.second;
-        auto itNode = prob.nodes.find(name); if (itNode == prob.nodes.end()) continue;
-        int t = std::max(1, itNode->second.getTimeCost());
-        // Count remaining consumers
-        int remaining = 0; auto itSucc = prob.successors.find(name);
-        if (itSucc != prob.successors.end()) {
-            for (const auto& cons : itSucc->second) if (state.computed.find(cons) == state.computed.end()) ++remaining;
-        }
-        if (remaining == 0) {
-            // Not needed anymore; just drop it for free
-            state.current_memory = std::max(0, state.current_memory - sz);
-            // defer erase until after loop to avoid iterator invalidation; mark by size 0
-            // But easier: erase now using a separate iterator pattern
-        }
-        double score = static_cast<double>(sz) / static_cast<double>(t);
-        if (score > bestScore) { bestScore = score; best = name; bestSize = sz; }
-    }
-    if (!best.empty()) {
-        state.output_memory.erase(best);
-        state.current_memory = std::max(0, state.current_memory - bestSize);
-        return true;
-    }
-    return false;
+    bool found = false; NodeId best = 0; double bestScore = -1.0;
+    std::vector<NodeId> dead;
+    state.resident.forEach([&](NodeId id) {
+        if (!hasPendingConsumer(prob, id, state)) { dead.push_back(id); return; }
+        int t = std::max(1, prob.recomputeCost(id));
+        double score = static_cast<double>(prob.nodes[id].getOutputMem()) / static_cast<double>(t);
+        if (score > bestScore) { found = true; bestScore = score; best = id; }
+    });
+    for (NodeId id : dead) spillOutput(prob, state, id);
+    if (found) spillOutput(prob, state, best);
+    return found || !dead.empty();
+}
+
+// Spill like trySpillBest, but never evict a pinned output; ties evict the latest-produced id
+static bool trySpillExcept(const Problem& prob, ScheduleState& state, const NodeBitset& pinned, NodeId* spilled = nullptr) {
+    bool found = false; NodeId best = 0; double bestScore = -1.0;
+    state.resident.forEach([&](NodeId id) {
+        if (pinned.test(id)) return;
+        double score = static_cast<double>(prob.nodes[id].getOutputMem()) / static_cast<double>(std::max(1, prob.recomputeCost(id)));
+        if (score >= bestScore) { found = true; bestScore = score; best = id; }
+    });
+    if (!found) return false;
+    spillOutput(prob, state, best);
+    if (spilled) *spilled = best;
+    return true;
 }
 
 // Garbage-collect outputs that have no remaining consumers
-static void garbageCollectOutputs(const Problem& prob, ScheduleState& state) {
-    std::vector<std::string> toErase;
-    for (const auto& kv : state.output_memory) {
-        const std::string& name = kv.first;
-        auto itSucc = prob.successors.find(name);
-        bool needed = false;
-        if (itSucc != prob.successors.end()) {
-            for (const auto& cons : itSucc->second) {
-                if (state.computed.find(cons) == state.computed.end()) { needed = true; break; }
-            }
+void garbageCollectOutputs(const Problem& prob, ScheduleState& state) {
+    std::vector<NodeId> toErase;
+    state.resident.forEach([&](NodeId id) {
+        if (!hasPendingConsumer(prob, id, state)) toErase.push_back(id);
+    });
+    for (NodeId id : toErase) spillOutput(prob, state, id);
+}
+
+std::vector<std::pair<size_t, NodeId>> releasePoints(const Problem& prob, const std::vector<ScheduleStep>& order) {
+    // Backward pass: after step p, drop each touched output that is not used again or whose next
+    // event is a recomputation (it was spilled in the original schedule) rather than a consumer
+    const size_t kNever = std::numeric_limits<size_t>::max();
+    std::vector<size_t> nextProduce(prob.size(), kNever), nextConsume(prob.size(), kNever);
+    std::vector<std::pair<size_t, NodeId>> drops;
+    for (size_t p = order.size(); p-- > 0;) {
+        NodeId v = order[p].node();
+        for (NodeId x : prob.inputs(v)) {
+            if (nextConsume[x] == kNever || nextProduce[x] < nextConsume[x]) drops.emplace_back(p, x);
         }
-        if (!needed) toErase.push_back(name);
+        if (nextConsume[v] == kNever || nextProduce[v] < nextConsume[v]) drops.emplace_back(p, v);
+        for (NodeId x : prob.inputs(v)) nextConsume[x] = p;
+        nextProduce[v] = p;
     }
-    for (const auto& name : toErase) {
-        auto it = state.output_memory.find(name);
-        if (it != state.output_memory.end()) {
-            state.current_memory = std::max(0, state.current_memory - it->second);
-            state.output_memory.erase(it);
+    std::reverse(drops.begin(), drops.end());
+    return drops;
+}
+
+ScheduleState replaySchedule(const Problem& prob, const std::vector<ScheduleStep>& order) {
+    const auto drops = releasePoints(prob, order);
+    ScheduleState state;
+    state.execution_order.reserve(order.size());
+    size_t d = 0;
+    for (size_t p = 0; p < order.size(); ++p) {
+        NodeId v = order[p].node();
+        if (!inputsResident(prob, v, state)) break; // not replayable from here on
+        applyNode(v, prob, state);
+        for (; d < drops.size() && drops[d].first == p; ++d) {
+            if (state.resident.test(drops[d].second)) spillOutput(prob, state, drops[d].second);
+        }
+    }
+    return state;
+}
+
+static std::vector<NodeId> sortedIds(IdRange range) {
+    std::vector<NodeId> ids(range.begin(), range.end());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+std::vector<NodeId> interchangeablePredecessors(const Problem& prob) {
+    std::vector<NodeId> prev(prob.size(), kNoNode);
+    // Bucket by a hash of the full signature, then confirm against each group's last member
+    auto signature = [&](NodeId id) {
+        const Node& n = prob.nodes[id];
+        size_t h = std::hash<long>{}(n.getRunMem()) ^ (std::hash<long>{}(n.getOutputMem()) << 1) ^ (std::hash<long>{}(n.getTimeCost()) << 2);
+        h ^= (std::hash<long>{}(prob.recomputeCost(id)) << 3) ^ (prob.in_place.test(id) ? 0x2545f491 : 0);
+        for (NodeId x : sortedIds(prob.inputs(id))) h ^= std::hash<uint64_t>{}(x) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= 0x51ed27;
+        for (NodeId x : sortedIds(prob.consumers(id))) h ^= std::hash<uint64_t>{}(x) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    };
+    auto same = [&](NodeId a, NodeId b) {
+        const Node& x = prob.nodes[a];
+        const Node& y = prob.nodes[b];
+        // An in-place node overwrites its first input, so that one must match too
+        bool inPlace = prob.in_place.test(a);
+        return x.getRunMem() == y.getRunMem() && x.getOutputMem() == y.getOutputMem() && x.getTimeCost() == y.getTimeCost() &&
+               prob.recomputeCost(a) == prob.recomputeCost(b) && inPlace == prob.in_place.test(b) &&
+               (!inPlace || *prob.inputs(a).begin() == *prob.inputs(b).begin()) &&
+               sortedIds(prob.inputs(a)) == sortedIds(prob.inputs(b)) &&
+               sortedIds(prob.consumers(a)) == sortedIds(prob.consumers(b));
+    };
+    std::unordered_map<size_t, std::vector<NodeId>> lastInGroup; // signature hash -> last member per group
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        auto& groups = lastInGroup[signature(id)];
+        bool placed = false;
+        for (NodeId& last : groups) {
+            if (same(last, id)) { prev[id] = last; last = id; placed = true; break; }
         }
+        if (!placed) groups.push_back(id);
+    }
+    return prev;
+}
+
+std::vector<NodeId> heuristicMoves(const Problem& prob, const ScheduleState& state, const std::vector<NodeId>& symPrev) {
+    auto ready = getReadyNodes(prob, state);
+    ready.erase(std::remove_if(ready.begin(), ready.end(), [&](NodeId id) {
+        return symPrev[id] != kNoNode && !state.computed.test(symPrev[id]);
+    }), ready.end());
+    if (ready.empty()) ready = getRecomputeCandidates(prob, state);
+    ready = pruneReadyListDynamic(ready, prob, state);
+    std::vector<std::pair<long, NodeId>> fitting;
+    for (NodeId id : ready) {
+        long predicted = calculateSequentialPeak(prob, id, state);
+        if (predicted <= prob.total_memory) fitting.emplace_back(predicted, id);
+    }
+    std::stable_sort(fitting.begin(), fitting.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<NodeId> moves;
+    moves.reserve(fitting.size());
+    for (const auto& f : fitting) moves.push_back(f.second);
+    return moves;
+}
+
+bool spillForProgress(const Problem& prob, ScheduleState& state) {
+    return trySpillBest(prob, state) || trySpillLargest(prob, state);
+}
+
+// Partial-order reduction: `a` (already explored from `state`) and `b` commute when neither
+// feeds the other and they share no input, so neither changes what the other frees and both
+// orders reach the same computed/resident set, memory and time. Running a first must also be
+// no worse for the peak; then the interleaving b, a can be skipped.
+static bool commutes(const Problem& prob, const ScheduleState& state, NodeId a, NodeId b) {
+    for (NodeId x : prob.inputs(b)) {
+        if (x == a) return false;
+        for (NodeId y : prob.inputs(a)) if (x == y) return false;
     }
+    for (NodeId y : prob.inputs(a)) if (y == b) return false;
+    long cur = state.current_memory;
+    // Disjoint inputs, so whether an in-place op can overwrite its first input is order-independent
+    long peakA = stepPeak(prob, a, state) - cur, peakB = stepPeak(prob, b, state) - cur;
+    long ab = std::max(cur + peakA, cur + calculateDynamicImpact(prob, a, state) + peakB);
+    long ba = std::max(cur + peakB, cur + calculateDynamicImpact(prob, b, state) + peakA);
+    return std::max(state.memory_peak, ab) <= std::max(state.memory_peak, ba);
 }
 
 static void dfsSchedule(const Problem& prob, ScheduleState& current, ScheduleState& best, bool& has_best) {
-    if (current.computed.size() == prob.nodes.size()) {
+    if (current.computed.count() == prob.size()) {
         if (!has_best || isBetterSchedule(current, best, prob.total_memory)) { best = current; has_best = true; }
         return;
     }
     // Opportunistic GC to tighten memory before expansion
     garbageCollectOutputs(prob, current);
-    auto ready = getReadyNodeNames(prob, current);
+    auto ready = getReadyNodes(prob, current);
     if (ready.empty()) return;
     ready = pruneReadyListDynamic(ready, prob, current);
-    for (const auto& nm : ready) {
-        const Node& node = prob.nodes.at(nm);
-        int predicted_peak = calculateSequentialPeak(current, node, current.current_memory);
+    for (NodeId id : ready) {
+        long predicted_peak = calculateSequentialPeak(prob, id, current);
         if (predicted_peak > prob.total_memory) continue;
-        ScheduleState next = executeNode(nm, prob, current);
+        ScheduleState next = executeNode(id, prob, current);
         dfsSchedule(prob, next, best, has_best);
     }
 }
 
-
-
-// Optimized version with caching and reduced redundant calculations
-struct NodeExpansionCache {
-    std::unordered_map<std::string, int> predicted_peaks;
-    std::unordered_map<std::string, int> dynamic_impacts;
-    
-    void clear() {
-        predicted_peaks.clear();
-        dynamic_impacts.clear();
-    }
-};
-
-// Fast ready node computation using cached node names for better memory access patterns
-static std::vector<std::string> getReadyNodeNamesOptimized(
-    const Problem& prob, 
-    const ScheduleState& state,
-    const std::vector<std::string>& node_names_cache) {
-    
-    std::vector<std::string> ready;
-    ready.reserve(node_names_cache.size());
-    
-    for (const auto& name : node_names_cache) {
-        if (state.computed.count(name)) continue;
-        
-        const Node& n = prob.nodes.at(name);
-        bool all_inputs_ready = true;
-        
-        // Early exit optimization for input checking
-        for (const auto& inName : n.getInputs()) {
-            if (state.output_memory.find(inName) == state.output_memory.end()) {
-                all_inputs_ready = false;
-                break;
-            }
-        }
-        
-        if (all_inputs_ready) {
-            ready.push_back(name);
-        }
-    }
-    return ready;
-}
-
 static void dfsScheduleLimited(const Problem& prob, ScheduleState& current, ScheduleState& best, bool& has_best,
                                size_t& expansionsLeft, const std::chrono::steady_clock::time_point& deadline,
+                               const std::vector<NodeId>& symPrev, const std::vector<NodeId>& sleep,
                                const DebugOptions* dbg, DebugStats* stats) {
     // Early termination checks - batch them for better branch prediction
     if (expansionsLeft == 0) return;
-    
+
     // Less frequent time checks to reduce syscall overhead
     static size_t time_check_counter = 0;
     if ((++time_check_counter & 0xFF) == 0) {  // Check every 256 expansions
-        if (std::chrono::steady_clock::now() > deadline) return;
+        if (std::chrono::steady_clock::now() > deadline) { expansionsLeft = 0; return; } // unwind the whole search
     }
-    
-    if (current.computed.size() == prob.nodes.size()) {
-        if (!has_best || isBetterSchedule(current, best, prob.total_memory)) { 
-            best = current; 
-            has_best = true; 
+
+    if (current.computed.count() == prob.size()) {
+        if (!has_best || isBetterSchedule(current, best, prob.total_memory)) {
+            best = current;
+            has_best = true;
         }
         return;
     }
-    
+
+    // Recompute/spill cycles could otherwise recurse until the stack runs out
+    if (current.execution_order.size() > 4 * prob.size() + 16) {
+        if (stats) stats->deadEnds++;
+        return;
+    }
+
     // Branch and bound: if current state is already worse than best known, prune
     if (has_best && current.total_time >= best.total_time && current.memory_peak >= best.memory_peak) {
         return;
     }
-    
-    // Memoization check: if we've seen this computed set before with better results, prune
-    auto memo_it = memo_cache.find(current.computed);
+
+    // Memoization check: if we've seen this computed set before with better results, prune. The
+    // earlier visit skipped its sleep set, so moves it slept on that are awake now still run here
+    std::vector<NodeId> onlyMoves;
+    auto memo_it = memo_cache.find(current.computed.words());
     if (memo_it != memo_cache.end()) {
-        if (current.total_time >= memo_it->second.first && current.memory_peak >= memo_it->second.second) {
-            return;
+        MemoEntry& e = memo_it->second;
+        if (current.total_time >= e.total_time && current.memory_peak >= e.memory_peak) {
+            for (NodeId a : e.sleep) if (std::find(sleep.begin(), sleep.end(), a) == sleep.end()) onlyMoves.push_back(a);
+            if (onlyMoves.empty()) return;
+            e.sleep.erase(std::remove_if(e.sleep.begin(), e.sleep.end(), [&](NodeId a) {
+                return std::find(onlyMoves.begin(), onlyMoves.end(), a) != onlyMoves.end();
+            }), e.sleep.end());
         }
     } else {
         // Store this state in memo cache
-        memo_cache[current.computed] = {current.total_time, current.memory_peak};
-    }
-    
-    // Cache node names for better memory access patterns
-    static thread_local std::vector<std::string> node_names_cache;
-    if (node_names_cache.empty()) {
-        node_names_cache.reserve(prob.nodes.size());
-        for (const auto& kv : prob.nodes) {
-            node_names_cache.push_back(kv.first);
-        }
+        memo_cache[current.computed.words()] = {current.total_time, current.memory_peak, sleep};
     }
-    
-    auto ready = getReadyNodeNamesOptimized(prob, current, node_names_cache);
+
+    auto ready = getReadyNodes(prob, current);
+    // Canonical order inside symmetry groups: a member's first run waits for its predecessor
+    ready.erase(std::remove_if(ready.begin(), ready.end(), [&](NodeId id) {
+        bool blocked = symPrev[id] != kNoNode && !current.computed.test(symPrev[id]);
+        if (blocked && stats) stats->prunedBySymmetry++;
+        return blocked;
+    }), ready.end());
     if (ready.empty()) {
         // Consider recomputation of needed but spilled outputs
         ready = getRecomputeCandidates(prob, current);
-        if (ready.empty()) { 
-            if (stats) stats->deadEnds++; 
-            return; 
+        if (ready.empty()) {
+            if (stats) stats->deadEnds++;
+            return;
         }
     }
-    
+
     ready = pruneReadyListDynamic(ready, prob, current);
-    
+
     // Pre-calculate predicted peaks to avoid redundant computation
-    std::vector<std::pair<std::string, int>> candidates_with_peaks;
+    std::vector<std::pair<NodeId, long>> candidates_with_peaks;
     candidates_with_peaks.reserve(ready.size());
-    
+
     bool allExceed = true;
-    for (const auto& nm : ready) {
-        const Node& node = prob.nodes.at(nm);
-        int predicted_peak = calculateSequentialPeak(current, node, current.current_memory);
-        candidates_with_peaks.emplace_back(nm, predicted_peak);
-        
+    for (NodeId id : ready) {
+        long predicted_peak = calculateSequentialPeak(prob, id, current);
+        candidates_with_peaks.emplace_back(id, predicted_peak);
+
         if (predicted_peak <= prob.total_memory) {
             allExceed = false;
         }
     }
-    
+
     if (allExceed) {
         ScheduleState spilled = current;
-        if (trySpillBest(prob, spilled) || trySpillLargest(spilled)) {
-            dfsScheduleLimited(prob, spilled, best, has_best, expansionsLeft, deadline, dbg, stats);
+        if (trySpillBest(prob, spilled) || trySpillLargest(prob, spilled)) {
+            dfsScheduleLimited(prob, spilled, best, has_best, expansionsLeft, deadline, symPrev, {}, dbg, stats);
         }
         return;
     }
-    
+
     // Sort candidates by predicted peak for better pruning (explore better candidates first)
     std::sort(candidates_with_peaks.begin(), candidates_with_peaks.end(),
               [](const auto& a, const auto& b) { return a.second < b.second; });
-    
-    for (const auto& [nm, predicted_peak] : candidates_with_peaks) {
+
+    // Sleep set: moves explored from an ancestor or an earlier sibling that commute with the
+    // path since then; their subtrees already cover the interleavings they would start here
+    std::vector<NodeId> explored = sleep;
+    for (const auto& [id, predicted_peak] : candidates_with_peaks) {
         if (expansionsLeft == 0) return;
-        
-        if (predicted_peak > prob.total_memory) { 
-            if (stats) stats->prunedByMemory++; 
-            continue; 
-        }
-        
-        ScheduleState next = executeNode(nm, prob, current);
-        --expansionsLeft; 
+
+        if (predicted_peak > prob.total_memory) {
+            if (stats) stats->prunedByMemory++;
+            continue;
+        }
+        if (std::find(sleep.begin(), sleep.end(), id) != sleep.end()) {
+            if (stats) stats->prunedBySleepSet++;
+            continue;
+        }
+        if (!onlyMoves.empty() && std::find(onlyMoves.begin(), onlyMoves.end(), id) == onlyMoves.end()) continue;
+        std::vector<NodeId> childSleep;
+        for (NodeId a : explored) if (commutes(prob, current, a, id)) childSleep.push_back(a);
+
+        ScheduleState next = executeNode(id, prob, current);
+        --expansionsLeft;
         if (stats) stats->expansions++;
-        
+
         if (dbg && dbg->trace) {
-            std::cerr << "expand: " << nm << " time=" << next.total_time
+            std::cerr << "expand: " << prob.name(id) << " time=" << next.total_time
                       << " curMem=" << next.current_memory << " peak=" << next.memory_peak
                       << " readyCount=" << ready.size() << " left=" << expansionsLeft << "\n";
         }
-        
-        dfsScheduleLimited(prob, next, best, has_best, expansionsLeft, deadline, dbg, stats);
+
+        dfsScheduleLimited(prob, next, best, has_best, expansionsLeft, deadline, symPrev, childSleep, dbg, stats);
+        explored.push_back(id);
     }
 }
 
 ScheduleState greedySchedule(const Problem& prob) {
     ScheduleState cur;
     // Simple greedy: repeatedly pick any ready node minimizing predicted peak, then time
-    while (cur.computed.size() < prob.nodes.size()) {
-        auto ready = getReadyNodeNames(prob, cur);
+    while (cur.computed.count() < prob.size()) {
+        auto ready = getReadyNodes(prob, cur);
         if (ready.empty()) break;
-        std::string bestName; int bestPredPeak = std::numeric_limits<int>::max(); int bestTime = std::numeric_limits<int>::max();
-        for (const auto& nm : ready) {
-            const Node& node = prob.nodes.at(nm);
-            int predicted_peak = calculateSequentialPeak(cur, node, cur.current_memory);
+        bool found = false; NodeId bestId = 0;
+        long bestPredPeak = std::numeric_limits<long>::max(); int bestTime = std::numeric_limits<int>::max();
+        for (NodeId id : ready) {
+            const Node& node = prob.nodes[id];
+            long predicted_peak = calculateSequentialPeak(prob, id, cur);
             if (predicted_peak > prob.total_memory) continue;
             int t = node.getTimeCost();
             if (predicted_peak < bestPredPeak || (predicted_peak == bestPredPeak && t < bestTime)) {
-                bestPredPeak = predicted_peak; bestTime = t; bestName = nm;
+                bestPredPeak = predicted_peak; bestTime = t; bestId = id; found = true;
             }
         }
-        if (bestName.empty()) break;
-        cur = executeNode(bestName, prob, cur);
+        if (!found) break;
+        cur = executeNode(bestId, prob, cur);
     }
     return cur;
 }
@@ -456,38 +534,218 @@ ScheduleState greedySchedule(const Problem& prob) {
 // Heuristic schedule: prioritize negative-impact nodes first; otherwise minimize (peak, time)
 ScheduleState heuristicSchedule(const Problem& prob) {
     ScheduleState cur;
-    while (cur.computed.size() < prob.nodes.size()) {
-        auto ready = getReadyNodeNames(prob, cur);
+    while (cur.computed.count() < prob.size()) {
+        auto ready = getReadyNodes(prob, cur);
         if (ready.empty()) break;
-        std::string bestName; int bestPredPeak = std::numeric_limits<int>::max(); int bestTime = std::numeric_limits<int>::max(); bool pickedNegative = false;
-        for (const auto& nm : ready) {
-            const Node& node = prob.nodes.at(nm);
-            int predicted_peak = calculateSequentialPeak(cur, node, cur.current_memory);
+        bool found = false; NodeId bestId = 0;
+        long bestPredPeak = std::numeric_limits<long>::max(); int bestTime = std::numeric_limits<int>::max(); bool pickedNegative = false;
+        for (NodeId id : ready) {
+            const Node& node = prob.nodes[id];
+            long predicted_peak = calculateSequentialPeak(prob, id, cur);
             if (predicted_peak > prob.total_memory) continue;
-            int dynImpact = calculateDynamicImpact(node, cur, prob.dependencies, cur.output_memory);
+            long dynImpact = calculateDynamicImpact(prob, id, cur);
             if (dynImpact <= 0) {
-                if (!pickedNegative || node.getPeak() < prob.nodes.at(bestName).getPeak()) { bestName = nm; pickedNegative = true; }
+                if (!pickedNegative || node.getPeak() < prob.nodes[bestId].getPeak()) { bestId = id; pickedNegative = true; found = true; }
                 continue;
             }
             if (pickedNegative) continue;
             int t = node.getTimeCost();
             if (predicted_peak < bestPredPeak || (predicted_peak == bestPredPeak && t < bestTime)) {
-                bestPredPeak = predicted_peak; bestTime = t; bestName = nm;
+                bestPredPeak = predicted_peak; bestTime = t; bestId = id; found = true;
+            }
+        }
+        if (!found) break;
+        cur = executeNode(bestId, prob, cur);
+    }
+    return cur;
+}
+
+// Runs `id`, first recomputing any of its inputs (and their missing ancestors) that were
+// spilled, and spilling unpinned outputs whenever the next step would exceed the budget.
+// Iterative, so long chains of spilled ancestors cannot overflow the stack. On failure `state`
+// is restored from a journal of the residency changes instead of from a copy; on success the
+// journaled ids are appended to `touched`.
+static bool materialize(const Problem& prob, ScheduleState& state, NodeId id,
+                        NodeBitset& pinned, size_t& stepsLeft, std::vector<NodeId>* touched = nullptr) {
+    const size_t steps = state.execution_order.size();
+    const long memory = state.current_memory, peak = state.memory_peak, time = state.total_time;
+    const bool wasComputed = state.computed.test(id);
+    std::vector<std::pair<NodeId, bool>> journal; // residency before each change
+    auto fail = [&] {
+        for (auto it = journal.rbegin(); it != journal.rend(); ++it) {
+            if (it->second) state.resident.set(it->first);
+            else state.resident.reset(it->first);
+        }
+        if (!wasComputed) state.computed.reset(id);
+        state.execution_order.erase(state.execution_order.begin() + static_cast<std::ptrdiff_t>(steps), state.execution_order.end());
+        state.current_memory = memory; state.memory_peak = peak; state.total_time = time;
+        return false;
+    };
+    struct Frame { NodeId id; const NodeId* next; };
+    std::vector<Frame> stack;
+    auto push = [&](NodeId v) {
+        for (NodeId input : prob.inputs(v)) pinned.set(input);
+        stack.push_back({v, prob.inputs(v).begin()});
+    };
+    push(id);
+    while (!stack.empty()) {
+        Frame& f = stack.back();
+        const NodeId* end = prob.inputs(f.id).end();
+        while (f.next != end && state.resident.test(*f.next)) ++f.next;
+        if (f.next != end) { push(*f.next++); continue; }
+        while (calculateSequentialPeak(prob, f.id, state) > prob.total_memory) {
+            NodeId spilled = kNoNode;
+            if (!trySpillExcept(prob, state, pinned, &spilled)) return fail();
+            journal.emplace_back(spilled, true);
+        }
+        if (stepsLeft == 0) return fail();
+        --stepsLeft;
+        for (NodeId input : prob.inputs(f.id)) journal.emplace_back(input, state.resident.test(input));
+        journal.emplace_back(f.id, state.resident.test(f.id));
+        applyNode(f.id, prob, state);
+        stack.pop_back();
+    }
+    if (touched) for (const auto& change : journal) touched->push_back(change.first);
+    return true;
+}
+
+// Priority rollout: among nodes whose inputs have all run at least once, score each with a
+// linear combination of normalized features (see PriorityWeights) and run the lowest score,
+// rematerializing spilled inputs on demand so tight budgets still produce a complete order.
+PriorityScales priorityScales(const Problem& prob) {
+    PriorityScales sc;
+    sc.mem = prob.total_memory > 0 ? static_cast<double>(prob.total_memory) : 1.0;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        sc.max_time = std::max(sc.max_time, prob.nodes[id].getTimeCost());
+        sc.max_fan_in = std::max(sc.max_fan_in, prob.inputs(id).size());
+        sc.max_fan_out = std::max(sc.max_fan_out, prob.consumers(id).size());
+    }
+    return sc;
+}
+
+// Features of `id` except PF_PredictedPeak, which is max(memory_peak, current_memory + need)
+// with the returned `need`: the node's peak plus its inputs that must be recomputed. Only that
+// max depends on more than the node's inputs, which lets prioritySchedule keep its ready queue keyed.
+static long priorityFeatures(const Problem& prob, const ScheduleState& state, NodeId id, const PriorityScales& sc,
+                             std::array<double, PF_Count>& f) {
+    const Node& node = prob.nodes[id];
+    long missing = 0;
+    for (NodeId input : prob.inputs(id)) {
+        if (!state.resident.test(input)) missing += prob.nodes[input].getOutputMem();
+    }
+    f[PF_DynamicImpact] = calculateDynamicImpact(prob, id, state) / sc.mem;
+    f[PF_PredictedPeak] = 0.0;
+    f[PF_TimeCost] = static_cast<double>(node.getTimeCost()) / sc.max_time;
+    f[PF_OutputMem] = node.getOutputMem() / sc.mem;
+    f[PF_RunMem] = node.getRunMem() / sc.mem;
+    f[PF_FanIn] = static_cast<double>(prob.inputs(id).size()) / static_cast<double>(sc.max_fan_in);
+    f[PF_FanOut] = static_cast<double>(prob.consumers(id).size()) / static_cast<double>(sc.max_fan_out);
+    return node.getPeak() + missing;
+}
+
+static double weightedSum(const PriorityWeights& weights, const std::array<double, PF_Count>& f) {
+    double score = 0.0;
+    for (int i = 0; i < PF_Count; ++i) score += weights.w[i] * f[i];
+    return score;
+}
+
+double priorityScore(const Problem& prob, const ScheduleState& state, NodeId id,
+                     const PriorityWeights& weights, const PriorityScales& sc) {
+    std::array<double, PF_Count> f{};
+    long need = priorityFeatures(prob, state, id, sc, f);
+    long predicted_peak = std::max<long>(state.memory_peak, state.current_memory + need);
+    f[PF_PredictedPeak] = predicted_peak / sc.mem;
+    return weightedSum(weights, f);
+}
+
+ScheduleState prioritySchedule(const Problem& prob, const PriorityWeights& weights) {
+    const PriorityScales scales = priorityScales(prob);
+    const double k = weights.w[PF_PredictedPeak] / scales.mem;
+    ScheduleState cur;
+    NodeBitset pinned;
+    size_t stepsLeft = 4 * prob.size() + 16; // bounds recomputation
+    // Ready queue: first runs whose inputs have all run, ordered both by base and by
+    // base + k * need (priorityFeatures). Every node not reached yet in either order scores at
+    // least max (min, for k < 0) of the two frontiers with the current peak and memory, so
+    // exact scores are taken in those orders until that bound passes the eighth best. Keys
+    // depend on the inputs alone: only consumers of outputs touched by a step are re-keyed.
+    using Key = std::pair<double, NodeId>;
+    std::set<Key> byBase, byNeed;
+    std::vector<Key> baseKey(prob.size()), needKey(prob.size());
+    NodeBitset queued;
+    auto enqueue = [&](NodeId id) {
+        std::array<double, PF_Count> f{};
+        long need = priorityFeatures(prob, cur, id, scales, f);
+        double base = weightedSum(weights, f);
+        baseKey[id] = {base, id};
+        needKey[id] = {base + k * static_cast<double>(need), id};
+        byBase.insert(baseKey[id]);
+        byNeed.insert(needKey[id]);
+        queued.set(id);
+    };
+    auto dequeue = [&](NodeId id) {
+        byBase.erase(baseKey[id]);
+        byNeed.erase(needKey[id]);
+        queued.reset(id);
+    };
+    std::vector<uint32_t> waiting(prob.size());
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        waiting[id] = static_cast<uint32_t>(prob.inputs(id).size());
+        if (waiting[id] == 0) enqueue(id);
+    }
+    std::vector<size_t> seen(prob.size(), 0);
+    std::vector<NodeId> touched;
+    std::vector<std::pair<double, NodeId>> scored;
+    size_t done = 0, collected = 0;
+    for (size_t step = 1; done < prob.size(); ++step) {
+        // Drop outputs nobody needs any more; only steps since the last pass can have made one
+        for (; collected < cur.execution_order.size(); ++collected) {
+            NodeId id = cur.execution_order[collected].node();
+            if (cur.resident.test(id) && !hasPendingConsumer(prob, id, cur)) { spillOutput(prob, cur, id); touched.push_back(id); }
+        }
+        for (NodeId x : touched) {
+            for (NodeId c : prob.consumers(x)) if (queued.test(c)) { dequeue(c); enqueue(c); }
+        }
+        touched.clear();
+
+        scored.clear();
+        const size_t want = std::min<size_t>(8, byBase.size());
+        const double peak = static_cast<double>(cur.memory_peak), memory = static_cast<double>(cur.current_memory);
+        auto look = [&](NodeId id) {
+            if (seen[id] == step) return;
+            seen[id] = step;
+            scored.emplace_back(priorityScore(prob, cur, id, weights, scales), id);
+        };
+        for (auto a = byBase.begin(), b = byNeed.begin(); a != byBase.end() && b != byNeed.end(); ++a, ++b) {
+            if (scored.size() >= want) {
+                std::nth_element(scored.begin(), scored.begin() + (want - 1), scored.end());
+                const double kth = scored[want - 1].first;
+                const double lo = k >= 0 ? std::max(a->first + k * peak, b->first + k * memory)
+                                         : std::min(a->first + k * peak, b->first + k * memory);
+                if (lo > kth + 1e-9 * (1.0 + std::fabs(kth))) break;
             }
+            look(a->second);
+            look(b->second);
+        }
+        // Try candidates best-first (ties by id); one whose rematerialization chain cannot fit is skipped
+        std::partial_sort(scored.begin(), scored.begin() + want, scored.end());
+        NodeId picked = kNoNode;
+        for (size_t i = 0; i < want && picked == kNoNode; ++i) {
+            pinned = NodeBitset{};
+            if (materialize(prob, cur, scored[i].second, pinned, stepsLeft, &touched)) picked = scored[i].second;
         }
-        if (bestName.empty()) break;
-        cur = executeNode(bestName, prob, cur);
+        if (picked == kNoNode) break;
+        ++done;
+        dequeue(picked);
+        for (NodeId c : prob.consumers(picked)) if (--waiting[c] == 0) enqueue(c);
     }
     return cur;
 }
 
 // Beam search: keep top-K partial schedules by (validity, time, peak)
-ScheduleState beamSearchSchedule(const Problem& prob, size_t beamWidth, size_t maxExpansions) {
+ScheduleState beamSearchSchedule(const Problem& prob, size_t beamWidth, size_t maxExpansions, size_t* expanded) {
     if (beamWidth == 0) beamWidth = 32;
     if (maxExpansions == 0) maxExpansions = 200000;
-    struct Entry { ScheduleState state; bool operator<(const Entry& /*other*/) const {
-        // We want a min-heap style comparison; but for vector sort we'll use explicit key
-        return false; } };
     std::vector<ScheduleState> beam; beam.reserve(beamWidth);
     beam.push_back(ScheduleState{});
     size_t expansions = 0;
@@ -495,19 +753,19 @@ ScheduleState beamSearchSchedule(const Problem& prob, size_t beamWidth, size_t m
     while (!beam.empty() && expansions < maxExpansions) {
         std::vector<ScheduleState> nextBeam;
         for (const auto& cur : beam) {
-            if (cur.computed.size() == prob.nodes.size()) {
+            if (cur.computed.count() == prob.size()) {
                 if (!has_best || isBetterSchedule(cur, best, prob.total_memory)) { best = cur; has_best = true; }
                 continue;
             }
-            auto ready = getReadyNodeNames(prob, cur);
+            auto ready = getReadyNodes(prob, cur);
             if (ready.empty()) continue;
             // Sort candidates by predicted peak then time
-            std::vector<std::pair<std::string, std::pair<int,int>>> cands;
-            for (const auto& nm : ready) {
-                const Node& node = prob.nodes.at(nm);
-                int p = calculateSequentialPeak(cur, node, cur.current_memory);
+            std::vector<std::pair<NodeId, std::pair<long,long>>> cands;
+            for (NodeId id : ready) {
+                const Node& node = prob.nodes[id];
+                long p = calculateSequentialPeak(prob, id, cur);
                 if (p > prob.total_memory) continue;
-                cands.push_back({nm, {p, node.getTimeCost()}});
+                cands.push_back({id, {p, node.getTimeCost()}});
             }
             std::sort(cands.begin(), cands.end(), [](const auto& a, const auto& b){
                 if (a.second.first != b.second.first) return a.second.first < b.second.first;
@@ -531,6 +789,7 @@ ScheduleState beamSearchSchedule(const Problem& prob, size_t beamWidth, size_t m
         if (nextBeam.size() > beamWidth) nextBeam.resize(beamWidth);
         beam.swap(nextBeam);
     }
+    if (expanded) *expanded = expansions;
     return has_best ? best : (beam.empty() ? ScheduleState{} : beam.front());
 }
 
@@ -539,38 +798,38 @@ ScheduleState dpGreedySchedule(const Problem& prob, size_t lookaheadDepth, size_
     if (lookaheadDepth == 0) lookaheadDepth = 2;
     if (branchFactor == 0) branchFactor = 8;
     ScheduleState cur;
-    while (cur.computed.size() < prob.nodes.size()) {
-        auto ready = getReadyNodeNames(prob, cur);
+    while (cur.computed.count() < prob.size()) {
+        auto ready = getReadyNodes(prob, cur);
         if (ready.empty()) break;
         // Score candidates by exploring up to lookaheadDepth with branching
-        std::string bestName; int bestPeak = std::numeric_limits<int>::max(); int bestTime = std::numeric_limits<int>::max();
+        bool found = false; NodeId bestId = 0;
+        long bestPeak = std::numeric_limits<long>::max(); int bestTime = std::numeric_limits<int>::max();
         // Rank current ready by predicted peak/time, take top branchFactor to explore deeper
-        std::vector<std::pair<std::string, std::pair<int,int>>> cands;
-        for (const auto& nm : ready) {
-            const Node& node = prob.nodes.at(nm);
-            int p = calculateSequentialPeak(cur, node, cur.current_memory);
-            cands.push_back({nm, {p, node.getTimeCost()}});
+        std::vector<std::pair<NodeId, std::pair<long,long>>> cands;
+        for (NodeId id : ready) {
+            const Node& node = prob.nodes[id];
+            long p = calculateSequentialPeak(prob, id, cur);
+            cands.push_back({id, {p, node.getTimeCost()}});
         }
         std::sort(cands.begin(), cands.end(), [](const auto& a, const auto& b){
             if (a.second.first != b.second.first) return a.second.first < b.second.first;
             return a.second.second < b.second.second;
         });
         size_t explore = std::min(cands.size(), branchFactor);
-        auto evalPath = [&](const ScheduleState& start, const std::string& first)->std::pair<int,int>{
+        auto evalPath = [&](const ScheduleState& start, NodeId first)->std::pair<long,long>{
             ScheduleState tmp = executeNode(first, prob, start);
             size_t depth = 1;
-            while (depth < lookaheadDepth && tmp.computed.size() < prob.nodes.size()) {
-                auto r = getReadyNodeNames(prob, tmp);
+            while (depth < lookaheadDepth && tmp.computed.count() < prob.size()) {
+                auto r = getReadyNodes(prob, tmp);
                 if (r.empty()) break;
                 // greedy inside lookahead: pick candidate minimizing predicted peak then time
-                std::string pick; int bestP = std::numeric_limits<int>::max(); int bestT = std::numeric_limits<int>::max();
-                for (const auto& nm : r) {
-                    const Node& node = prob.nodes.at(nm);
-                    int p = calculateSequentialPeak(tmp, node, tmp.current_memory);
+                NodeId pick = r.front(); long bestP = std::numeric_limits<long>::max(); int bestT = std::numeric_limits<int>::max();
+                for (NodeId id : r) {
+                    const Node& node = prob.nodes[id];
+                    long p = calculateSequentialPeak(prob, id, tmp);
                     int t = node.getTimeCost();
-                    if (p < bestP || (p == bestP && t < bestT)) { bestP = p; bestT = t; pick = nm; }
+                    if (p < bestP || (p == bestP && t < bestT)) { bestP = p; bestT = t; pick = id; }
                 }
-                if (pick.empty()) break;
                 tmp = executeNode(pick, prob, tmp);
                 ++depth;
             }
@@ -579,29 +838,185 @@ ScheduleState dpGreedySchedule(const Problem& prob, size_t lookaheadDepth, size_
         for (size_t i = 0; i < explore; ++i) {
             auto [p, t] = evalPath(cur, cands[i].first);
             if (p <= prob.total_memory && (p < bestPeak || (p == bestPeak && t < bestTime))) {
-                bestPeak = p; bestTime = t; bestName = cands[i].first;
+                bestPeak = p; bestTime = t; bestId = cands[i].first; found = true;
             }
         }
-        if (bestName.empty()) {
+        if (!found) {
             // fall back to immediate best by predicted peak
-            bestName = cands.front().first;
+            bestId = cands.front().first;
         }
-        cur = executeNode(bestName, prob, cur);
+        cur = executeNode(bestId, prob, cur);
     }
     return cur;
 }
 
+long remainingTimeLowerBound(const Problem& prob, const ScheduleState& state) {
+    long h = 0;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        if (!state.computed.test(id)) h += prob.nodes[id].getTimeCost();
+        else if (!state.resident.test(id) && hasPendingConsumer(prob, id, state)) h += prob.recomputeCost(id);
+    }
+    return h;
+}
+
+namespace {
+struct OpenEntry {
+    long bound; // g + h, the admissible part of the key
+    ScheduleState state;
+};
+
+// Open list bucketed by f / width; pops the lowest bucket, newest entry first (deepest on ties)
+class BucketQueue {
+public:
+    explicit BucketQueue(long width) : width_(std::max(1L, width)) {}
+    void push(long f, OpenEntry e) {
+        size_t b = static_cast<size_t>(std::max(0L, f) / width_);
+        if (b >= buckets_.size()) buckets_.resize(b + 1);
+        buckets_[b].push_back(std::move(e));
+        cursor_ = std::min(cursor_, b);
+        ++size_;
+    }
+    OpenEntry pop() {
+        while (buckets_[cursor_].empty()) ++cursor_;
+        OpenEntry e = std::move(buckets_[cursor_].back());
+        buckets_[cursor_].pop_back();
+        --size_;
+        return e;
+    }
+    // Keeps the `keep` entries in the lowest buckets; returns the smallest bound dropped
+    long cut(size_t keep) {
+        long dropped = std::numeric_limits<long>::max();
+        size_t kept = 0;
+        for (size_t b = cursor_; b < buckets_.size(); ++b) {
+            auto& bucket = buckets_[b];
+            if (kept >= keep) {
+                for (const OpenEntry& e : bucket) dropped = std::min(dropped, e.bound);
+                std::vector<OpenEntry>().swap(bucket);
+                continue;
+            }
+            size_t room = keep - kept;
+            if (bucket.size() > room) {
+                // Deeper (newer) entries sit at the back; drop the shallow ones at the front
+                for (size_t i = 0; i < bucket.size() - room; ++i) dropped = std::min(dropped, bucket[i].bound);
+                bucket.erase(bucket.begin(), bucket.begin() + static_cast<long>(bucket.size() - room));
+            }
+            kept += bucket.size();
+        }
+        size_ = kept;
+        return dropped;
+    }
+    long minBound() const {
+        long m = std::numeric_limits<long>::max();
+        for (size_t b = cursor_; b < buckets_.size(); ++b)
+            for (const OpenEntry& e : buckets_[b]) m = std::min(m, e.bound);
+        return m;
+    }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    long width_;
+    std::vector<std::vector<OpenEntry>> buckets_;
+    size_t cursor_{0};
+    size_t size_{0};
+};
+} // namespace
+
+ScheduleState astarSchedule(const Problem& prob, const AStarOptions& opts, AStarStats* stats) {
+    AStarStats local;
+    AStarStats& st = stats ? *stats : local;
+    st = AStarStats{};
+    const double weight = std::max(1.0, opts.weight);
+    const size_t maxOpen = std::max<size_t>(opts.max_open, 2);
+    const size_t maxExpansions = opts.max_expansions ? opts.max_expansions : 200000;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(opts.time_limit > 0.0 ? opts.time_limit : 5.0));
+    auto symPrev = interchangeablePredecessors(prob);
+    TranspositionTable closed(opts.table_entries ? opts.table_entries : 1);
+
+    auto fOf = [&](long g, long h) { return g + static_cast<long>(weight * static_cast<double>(h)); };
+    ScheduleState init;
+    long h0 = remainingTimeLowerBound(prob, init);
+    // Exact buckets unless the f range is wide enough to need more than ~64k of them. Wider
+    // buckets pop out of f order, so weight 1 then keeps going until nothing open can beat the
+    // first complete state (entries at or above the incumbent are skipped as they come up).
+    const long width = fOf(0, h0) / 65536;
+    const bool stopAtFirst = !opts.anytime && (weight > 1.0 || width <= 1);
+    BucketQueue open(width);
+    open.push(fOf(0, h0), {h0, init});
+    closed.store(stateKey(init), 0, 0);
+
+    ScheduleState best; bool has_best = false;
+    long droppedBound = std::numeric_limits<long>::max();
+    while (!open.empty()) {
+        if (st.expansions >= maxExpansions ||
+            ((st.expansions & 0xFF) == 0 && std::chrono::steady_clock::now() > deadline)) break;
+        OpenEntry e = open.pop();
+        ScheduleState& cur = e.state;
+        if (has_best && e.bound >= best.total_time) continue; // cannot improve the incumbent
+        if (cur.computed.count() == prob.size()) {
+            if (!has_best || isBetterSchedule(cur, best, prob.total_memory)) { best = cur; has_best = true; }
+            if (stopAtFirst) break;
+            continue;
+        }
+        ++st.expansions;
+
+        // Move generation mirrors dfsScheduleLimited: first runs, else forced recomputes, else a spill
+        auto moves = getReadyNodes(prob, cur);
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [&](NodeId id) {
+            return symPrev[id] != kNoNode && !cur.computed.test(symPrev[id]);
+        }), moves.end());
+        if (moves.empty()) moves = getRecomputeCandidates(prob, cur);
+        moves = pruneReadyListDynamic(moves, prob, cur);
+        // Worst (peak, memory impact) first, so the best is pushed last and popped first on f ties
+        std::vector<std::tuple<long, long, NodeId>> fitting;
+        for (NodeId id : moves) {
+            long predicted = calculateSequentialPeak(prob, id, cur);
+            if (predicted <= prob.total_memory) fitting.emplace_back(predicted, calculateDynamicImpact(prob, id, cur), id);
+        }
+        std::sort(fitting.begin(), fitting.end(), std::greater<>());
+        std::vector<ScheduleState> children;
+        for (const auto& m : fitting) children.push_back(executeNode(std::get<2>(m), prob, cur));
+        if (children.empty() && !moves.empty()) {
+            ScheduleState spilled = cur;
+            if (trySpillBest(prob, spilled) || trySpillLargest(prob, spilled)) children.push_back(std::move(spilled));
+        }
+        for (ScheduleState& child : children) {
+            uint64_t key = stateKey(child);
+            if (closed.dominated(key, child.total_time, child.memory_peak)) { ++st.closed_hits; continue; }
+            closed.store(key, child.total_time, child.memory_peak);
+            long h = remainingTimeLowerBound(prob, child);
+            long g = child.total_time;
+            if (has_best && g + h >= best.total_time) continue;
+            ++st.generated;
+            open.push(fOf(g, h), {g + h, std::move(child)});
+        }
+        st.max_open = std::max(st.max_open, open.size());
+        if (open.size() > maxOpen) {
+            droppedBound = std::min(droppedBound, open.cut(maxOpen / 2));
+            ++st.beam_cuts;
+        }
+    }
+
+    // Anything still open or cut away may hold a faster schedule
+    long bound = std::min(droppedBound, open.minBound());
+    if (has_best) bound = std::min(bound, best.total_time);
+    st.lower_bound = bound == std::numeric_limits<long>::max() ? h0 : bound;
+    st.optimal = has_best && st.lower_bound >= best.total_time;
+    return has_best ? best : ScheduleState{};
+}
+
 ScheduleState dfsScheduleLimited(const Problem& prob, size_t maxExpansions, double timeLimitSeconds) {
     // Clear memoization cache at start of new search
     memo_cache.clear();
-    
+
     ScheduleState init; ScheduleState best; bool has_best = false;
     if (maxExpansions == 0) maxExpansions = 200000;
     if (timeLimitSeconds <= 0.0) timeLimitSeconds = 5.0;
     auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
         std::chrono::duration<double>(timeLimitSeconds));
     size_t left = maxExpansions;
-    dfsScheduleLimited(prob, init, best, has_best, left, deadline, nullptr, nullptr);
+    dfsScheduleLimited(prob, init, best, has_best, left, deadline, interchangeablePredecessors(prob), {}, nullptr, nullptr);
     return has_best ? best : ScheduleState{};
 }
 
@@ -609,18 +1024,20 @@ ScheduleState scheduleWithDebug(const Problem& prob, size_t maxExpansions, doubl
                                 const DebugOptions& opts, DebugStats& stats) {
     // Clear memoization cache at start of new search
     memo_cache.clear();
-    
+
     ScheduleState init; ScheduleState best; bool has_best = false;
     if (maxExpansions == 0) maxExpansions = 200000;
     if (timeLimitSeconds <= 0.0) timeLimitSeconds = 5.0;
     auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
         std::chrono::duration<double>(timeLimitSeconds));
     size_t left = maxExpansions;
-    dfsScheduleLimited(prob, init, best, has_best, left, deadline, &opts, &stats);
+    dfsScheduleLimited(prob, init, best, has_best, left, deadline, interchangeablePredecessors(prob), {}, &opts, &stats);
     if (opts.verbose) {
         std::cerr << "dbg: expansions=" << stats.expansions
                   << " prunedByMemory=" << stats.prunedByMemory
                   << " deadEnds=" << stats.deadEnds
+                  << " prunedBySymmetry=" << stats.prunedBySymmetry
+                  << " prunedBySleepSet=" << stats.prunedBySleepSet
                   << " memoHits=" << memo_cache.size()
                   << " found=" << (has_best ? 1 : 0) << "\n";
     }
@@ -0,0 +1,248 @@
+#include "selector.hpp"
+#include "blocks.hpp"
+#include "cp.hpp"
+#include "lds.hpp"
+#include "parallel.hpp"
+#include "remat.hpp"
+#include "storage.hpp"
+#include "tabu.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static SelectorRule makeRule(int feature, double threshold, StrategyChoice choice) {
+    SelectorRule r;
+    if (feature >= 0) r.conditions.push_back({feature, true, threshold});
+    r.choice = std::move(choice);
+    return r;
+}
+
+static StrategyChoice makeChoice(const std::string& scheduler, size_t maxExpansions, double timeLimit,
+                                 double perNode = 0.0) {
+    StrategyChoice c;
+    c.scheduler = scheduler;
+    c.max_expansions = maxExpansions;
+    c.time_limit = timeLimit;
+    c.expansions_per_node = perNode;
+    return c;
+}
+
+StrategySelector defaultStrategySelector() {
+    StrategySelector sel;
+    sel.rules.push_back(makeRule(GF_Nodes, 50000, makeChoice("priority", 200000, 1.0)));
+    sel.rules.push_back(makeRule(GF_Nodes, 10000, makeChoice("dfs", 500, 1.0, 0.01)));
+    sel.rules.push_back(makeRule(GF_Nodes, 1000, makeChoice("dfs", 10000, 3.0, 1.0)));
+    sel.rules.push_back(makeRule(GF_Nodes, 50, makeChoice("tabu", 1000, 5.0)));
+    sel.rules.push_back(makeRule(-1, 0, makeChoice("greedy", 200000, 5.0)));
+    return sel;
+}
+
+StrategyChoice selectStrategy(const StrategySelector& sel, const GraphFeatures& gf) {
+    for (const auto& rule : sel.rules) {
+        bool match = true;
+        for (const auto& c : rule.conditions) {
+            double v = gf.v[c.feature];
+            if (c.greater ? !(v > c.threshold) : !(v <= c.threshold)) { match = false; break; }
+        }
+        if (!match) continue;
+        StrategyChoice c = rule.choice;
+        if (c.expansions_per_node > 0.0) {
+            size_t cap = static_cast<size_t>(c.expansions_per_node * gf.v[GF_Nodes]);
+            c.max_expansions = std::min(c.max_expansions, std::max<size_t>(1, cap));
+        }
+        return c;
+    }
+    return StrategyChoice{};
+}
+
+static bool isKnownScheduler(const std::string& name) {
+    static const char* const kNames[] = {"dfs", "greedy", "heuristic", "priority", "beam", "dpgreedy", "blocks", "astar", "cp", "lds", "restarts", "tabu", "remat", "storage"};
+    for (const char* n : kNames) if (name == n) return true;
+    return false;
+}
+
+static bool applyParam(StrategyChoice& c, const std::string& kv) {
+    auto eq = kv.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = kv.substr(0, eq), val = kv.substr(eq + 1);
+    try {
+        if (key == "max_expansions") c.max_expansions = std::stoul(val);
+        else if (key == "time_limit") c.time_limit = std::stod(val);
+        else if (key == "beam_width") c.beam_width = std::stoul(val);
+        else if (key == "lookahead") c.lookahead = std::stoul(val);
+        else if (key == "branch") c.branch = std::stoul(val);
+        else if (key == "weight") c.weight = std::stod(val);
+        else if (key == "threads") c.threads = std::stoul(val);
+        else if (key == "threshold") c.threshold = std::stod(val);
+        else if (key == "expansions_per_node") c.expansions_per_node = std::stod(val);
+        else return false;
+    } catch (...) { return false; }
+    return true;
+}
+
+bool loadStrategySelector(const std::string& path, StrategySelector& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) { error = "Failed to open selector file: " + path; return false; }
+    StrategySelector sel;
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::stringstream ss(line);
+        std::vector<std::string> tok;
+        for (std::string t; ss >> t;) tok.push_back(t);
+        if (tok.empty()) continue;
+        auto where = " on line " + std::to_string(line_no);
+        SelectorRule rule;
+        size_t i = 0;
+        for (; i < tok.size() && tok[i] != "->"; i += 3) {
+            if (i + 2 >= tok.size()) { error = "Incomplete condition" + where; return false; }
+            SelectorCondition c;
+            c.feature = graphFeatureIndex(tok[i]);
+            if (c.feature < 0) { error = "Unknown feature '" + tok[i] + "'" + where; return false; }
+            if (tok[i + 1] == ">") c.greater = true;
+            else if (tok[i + 1] == "<=") c.greater = false;
+            else { error = "Unknown operator '" + tok[i + 1] + "'" + where; return false; }
+            try { c.threshold = std::stod(tok[i + 2]); } catch (...) { error = "Invalid threshold" + where; return false; }
+            rule.conditions.push_back(c);
+        }
+        if (i + 1 >= tok.size()) { error = "Missing '-> <scheduler>'" + where; return false; }
+        rule.choice.scheduler = tok[i + 1];
+        if (!isKnownScheduler(rule.choice.scheduler)) { error = "Unknown scheduler '" + tok[i + 1] + "'" + where; return false; }
+        for (size_t k = i + 2; k < tok.size(); ++k) {
+            if (!applyParam(rule.choice, tok[k])) { error = "Invalid parameter '" + tok[k] + "'" + where; return false; }
+        }
+        sel.rules.push_back(std::move(rule));
+    }
+    if (sel.rules.empty()) { error = "No rules in selector file: " + path; return false; }
+    out = std::move(sel);
+    return true;
+}
+
+std::string describeStrategy(const StrategyChoice& c) {
+    std::ostringstream os;
+    os.precision(9);
+    os << c.scheduler;
+    if (c.scheduler == "dfs" || c.scheduler == "blocks" || c.scheduler == "cp") os << " max_expansions=" << c.max_expansions << " time_limit=" << c.time_limit;
+    else if (c.scheduler == "beam") os << " beam_width=" << c.beam_width << " max_expansions=" << c.max_expansions;
+    else if (c.scheduler == "dpgreedy") os << " lookahead=" << c.lookahead << " branch=" << c.branch;
+    else if (c.scheduler == "lds" || c.scheduler == "restarts" || c.scheduler == "tabu") os << " max_expansions=" << c.max_expansions << " time_limit=" << c.time_limit << " threads=" << c.threads;
+    else if (c.scheduler == "remat") os << " threshold=" << c.threshold;
+    else if (c.scheduler == "astar") os << " weight=" << c.weight << " max_expansions=" << c.max_expansions << " time_limit=" << c.time_limit;
+    if (c.expansions_per_node > 0.0) os << " expansions_per_node=" << c.expansions_per_node;
+    return os.str();
+}
+
+bool saveStrategySelector(const std::string& path, const StrategySelector& sel, std::string& error) {
+    std::ofstream out(path);
+    if (!out) { error = "Failed to write selector file: " + path; return false; }
+    out.precision(9);
+    out << "# <feature> <op> <value> ... -> <scheduler> [key=value ...]\n";
+    for (const auto& rule : sel.rules) {
+        for (const auto& c : rule.conditions) {
+            out << graphFeatureName(c.feature) << (c.greater ? " > " : " <= ") << c.threshold << " ";
+        }
+        out << "-> " << describeStrategy(rule.choice) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+static ScheduleState runSearch(const Problem& prob, const StrategyChoice& c, const PriorityWeights& weights,
+                               SearchReport* report) {
+    if (c.scheduler == "greedy") return greedySchedule(prob);
+    if (c.scheduler == "heuristic") return heuristicSchedule(prob);
+    if (c.scheduler == "priority") return prioritySchedule(prob, weights);
+    if (c.scheduler == "beam") return beamSearchSchedule(prob, c.beam_width, c.max_expansions, report ? &report->expansions : nullptr);
+    if (c.scheduler == "dpgreedy") return dpGreedySchedule(prob, c.lookahead, c.branch);
+    if (c.scheduler == "astar") {
+        AStarOptions opts;
+        opts.weight = c.weight;
+        opts.anytime = c.weight > 1.0;
+        opts.max_expansions = c.max_expansions;
+        opts.time_limit = c.time_limit;
+        AStarStats st;
+        ScheduleState s = astarSchedule(prob, opts, &st);
+        if (report) { report->lower_bound = st.lower_bound; report->expansions = st.expansions; }
+        return s;
+    }
+    if (c.scheduler == "lds" || c.scheduler == "restarts") {
+        DiversifiedOptions opts;
+        opts.max_expansions = c.max_expansions;
+        opts.time_limit = c.time_limit;
+        opts.threads = c.threads;
+        // Parallel restarts skip subtrees another run already finished
+        if ((c.threads ? c.threads : defaultThreadCount()) > 1) opts.shared_entries = std::min<size_t>(2 * c.max_expansions, size_t{1} << 20);
+        DiversifiedStats st;
+        ScheduleState s = c.scheduler == "lds" ? ldsSchedule(prob, opts, &st) : restartSchedule(prob, opts, &st);
+        if (report) report->expansions = st.expansions;
+        return s;
+    }
+    if (c.scheduler == "tabu" || c.scheduler == "remat" || c.scheduler == "storage") {
+        // Drop decisions over the first-run order of the block schedule, or of the priority
+        // rollout when that one fits and the block schedule does not (or is slower)
+        BlockOptions seedOpts;
+        seedOpts.time_limit = std::min(1.0, c.time_limit);
+        seedOpts.relax_budget = true;
+        ScheduleState seed = blockReplicatedSchedule(prob, seedOpts);
+        ScheduleState rollout = prioritySchedule(prob, weights);
+        if (rollout.computed.count() == prob.size() && isBetterSchedule(rollout, seed, prob.total_memory)) seed = rollout;
+        if (c.scheduler == "remat") {
+            EagerRematOptions opts;
+            opts.threshold = c.threshold;
+            EagerRematStats st;
+            ScheduleState s = eagerRematSchedule(prob, seed, opts, &st);
+            if (report) report->expansions = st.probes;
+            return s;
+        }
+        if (c.scheduler == "storage") {
+            StorageStats st;
+            ScheduleState s = storageSchedule(prob, seed, StorageOptions{}, &st, nullptr,
+                                              report ? &report->storage_events : nullptr);
+            if (report) report->expansions = st.probes;
+            return s;
+        }
+        TabuOptions opts;
+        opts.max_iterations = c.max_expansions;
+        opts.time_limit = c.time_limit;
+        opts.threads = c.threads;
+        TabuStats st;
+        ScheduleState s = tabuSchedule(prob, seed, opts, &st);
+        if (report) report->expansions = st.decodes;
+        return s;
+    }
+    if (c.scheduler == "cp") {
+        CpOptions opts;
+        opts.max_nodes = c.max_expansions;
+        opts.time_limit = c.time_limit;
+        opts.weights = weights;
+        CpStats st;
+        ScheduleState s = cpSchedule(prob, opts, &st);
+        if (report) { report->lower_bound = st.lower_bound; report->expansions = st.nodes; }
+        return s;
+    }
+    if (!report) return dfsScheduleLimited(prob, c.max_expansions, c.time_limit);
+    DebugStats st;
+    ScheduleState s = scheduleWithDebug(prob, c.max_expansions, c.time_limit, DebugOptions{}, st);
+    report->expansions = st.expansions;
+    return s;
+}
+
+ScheduleState runStrategy(const Problem& prob, const StrategyChoice& c, const PriorityWeights& weights,
+                          ScheduleCache* cache, SearchReport* report) {
+    if (c.scheduler == "blocks") {
+        BlockOptions opts;
+        opts.max_expansions = c.max_expansions;
+        opts.time_limit = c.time_limit;
+        opts.cache = cache;
+        return blockReplicatedSchedule(prob, opts);
+    }
+    if (!cache || c.scheduler == "storage") return runSearch(prob, c, weights, report);
+    uint64_t hash = blockHash(prob, 0, static_cast<uint32_t>(prob.size()));
+    ScheduleState s;
+    if (cache->lookup(hash, prob, prob.total_memory, s)) return s;
+    s = runSearch(prob, c, weights, report);
+    if (s.computed.count() == prob.size() && s.memory_peak <= prob.total_memory) cache->offer(hash, prob.total_memory, s);
+    return s;
+}
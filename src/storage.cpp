@@ -0,0 +1,139 @@
+#include "storage.hpp"
+#include "decode.hpp"
+#include "tabu.hpp"
+#include <algorithm>
+
+const char* storageActionName(StorageAction action) {
+    switch (action) {
+    case StorageAction::Keep: return "keep";
+    case StorageAction::Recompute: return "recompute";
+    case StorageAction::Compress: return "compress";
+    case StorageAction::Offload: return "offload";
+    }
+    return "?";
+}
+
+ScheduleState decodeStoragePlan(const Problem& prob, const std::vector<NodeId>& order,
+                                const std::vector<StorageAction>& plan, StorageStats* stats,
+                                std::vector<StorageEvent>* events) {
+    StorageStats local;
+    StorageStats& st = stats ? *stats : local;
+    st.recomputed = st.compressed = st.offloaded = st.encodes = st.decodes = st.transfers = 0;
+    for (NodeId x = 0; x < plan.size(); ++x) {
+        if (plan[x] == StorageAction::Recompute) ++st.recomputed;
+        else if (plan[x] == StorageAction::Compress) ++st.compressed;
+        else if (plan[x] == StorageAction::Offload) ++st.offloaded;
+    }
+
+    // Non-kept outputs are encoded or offloaded when they leave (recomputed ones just drop) and
+    // restored from the stored copy; the copy goes with the last consumer
+    struct Policy {
+        const Problem& prob;
+        ScheduleState& s;
+        StorageStats& st;
+        const std::vector<StorageAction>& plan;
+        std::vector<StorageEvent>* events;
+        NodeBitset stored; // encoded or host copy present
+        StorageAction action(NodeId x) const { return x < plan.size() ? plan[x] : StorageAction::Keep; }
+        // Device bytes of the stored copy
+        long copyMem(NodeId x) const { return action(x) == StorageAction::Compress ? prob.storage[x].compressed_mem : 0; }
+        void event(NodeId x, StorageEventKind kind) {
+            if (events) events->push_back({static_cast<uint32_t>(s.execution_order.size()), x, kind});
+        }
+        void enter(size_t) {}
+        bool onDemand(NodeId v) const { return action(v) == StorageAction::Recompute; }
+        bool kept(NodeId id) const { return action(id) == StorageAction::Keep; }
+        void beforeRun(NodeId) {}
+        void afterRun(NodeId id) {
+            for (NodeId x : prob.inputs(id)) {
+                if (stored.test(x) && !hasPendingConsumer(prob, x, s)) { s.current_memory -= copyMem(x); stored.reset(x); }
+            }
+        }
+        bool restore(NodeId x) {
+            if (!stored.test(x)) return false;
+            const StorageCosts& c = prob.storage[x];
+            if (action(x) == StorageAction::Compress) { s.total_time += c.decode_time; ++st.decodes; event(x, StorageEventKind::Decode); }
+            else { s.total_time += c.transfer_time; ++st.transfers; event(x, StorageEventKind::Restore); }
+            s.resident.set(x);
+            s.current_memory += prob.nodes[x].getOutputMem();
+            s.memory_peak = std::max(s.memory_peak, s.current_memory);
+            return true;
+        }
+        void release(NodeId x) {
+            if (action(x) != StorageAction::Recompute && !stored.test(x)) {
+                const StorageCosts& c = prob.storage[x];
+                if (action(x) == StorageAction::Compress) { s.total_time += c.encode_time; ++st.encodes; event(x, StorageEventKind::Encode); }
+                else { s.total_time += c.transfer_time; ++st.transfers; event(x, StorageEventKind::Offload); }
+                s.memory_peak = std::max(s.memory_peak, s.current_memory + copyMem(x)); // both copies while encoding
+                s.current_memory += copyMem(x);
+                stored.set(x);
+            }
+            spillOutput(prob, s, x);
+        }
+    };
+    ScheduleState s;
+    if (events) events->clear();
+    Policy policy{prob, s, st, plan, events, NodeBitset{}};
+    decodeFirstRunOrder(prob, order, s, policy);
+    return s;
+}
+
+std::vector<StorageOption> rankStorageOptions(const Problem& prob, double migrate_per_byte, bool storage_costs) {
+    std::vector<StorageOption> ranked, escalate;
+    for (NodeId x = 0; x < prob.size(); ++x) {
+        const double out = prob.nodes[x].getOutputMem();
+        if (prob.consumers(x).empty() || out <= 0) continue;
+        const double later = std::max<double>(1.0, static_cast<double>(prob.consumers(x).size()) - 1.0); // uses after the first
+        StorageOption full{prob.recomputeCost(x) * later / out, x, StorageAction::Recompute};
+        const StorageCosts* c = storage_costs && !prob.storage.empty() ? &prob.storage[x] : nullptr;
+        double offload = -1.0;
+        if (migrate_per_byte >= 0.0) offload = migrate_per_byte * (1.0 + later);
+        else if (c && c->transfer_time >= 0) offload = c->transfer_time * (1.0 + later) / out;
+        if (offload >= 0.0 && offload < full.cost) full = {offload, x, StorageAction::Offload};
+        StorageOption best = full;
+        if (c && c->compressed_mem >= 0 && c->compressed_mem < out) {
+            double cost = (c->encode_time + c->decode_time * later) / (out - c->compressed_mem);
+            if (cost < best.cost) best = {cost, x, StorageAction::Compress};
+        }
+        ranked.push_back(best);
+        if (best.action == StorageAction::Compress) escalate.push_back(full);
+    }
+    std::sort(ranked.begin(), ranked.end());
+    std::sort(escalate.begin(), escalate.end());
+    ranked.insert(ranked.end(), escalate.begin(), escalate.end());
+    return ranked;
+}
+
+std::vector<StorageAction> storagePrefixPlan(const Problem& prob, const std::vector<StorageOption>& ranked, size_t k) {
+    std::vector<StorageAction> plan(prob.size(), StorageAction::Keep);
+    for (size_t i = 0; i < k; ++i) plan[ranked[i].node] = ranked[i].action;
+    return plan;
+}
+
+ScheduleState storageSchedule(const Problem& prob, const ScheduleState& seed, const StorageOptions& opts,
+                              StorageStats* stats, std::vector<StorageAction>* plan, std::vector<StorageEvent>* events) {
+    StorageStats local;
+    StorageStats& st = stats ? *stats : local;
+    st = StorageStats{};
+    const std::vector<NodeId> order = firstRunOrder(prob, seed);
+    const std::vector<StorageOption> ranked = rankStorageOptions(prob, -1.0, true);
+
+    struct Probe {
+        ScheduleState state;
+        StorageStats stats;
+    };
+    auto decode = [&](size_t k) {
+        Probe p;
+        p.state = decodeStoragePlan(prob, order, storagePrefixPlan(prob, ranked, k), &p.stats);
+        return p;
+    };
+    size_t probes = 0, bestK = 0;
+    Probe best = searchStoragePrefix(prob, ranked.size(), opts.max_probes, probes, decode,
+                                     [](const Probe& p) -> const ScheduleState& { return p.state; }, &bestK);
+    st = best.stats;
+    st.probes = probes;
+    st.fits = best.state.computed.count() == prob.size() && best.state.memory_peak <= prob.total_memory;
+    if (plan) *plan = storagePrefixPlan(prob, ranked, bestK);
+    if (events) decodeStoragePlan(prob, order, storagePrefixPlan(prob, ranked, bestK), nullptr, events);
+    return std::move(best.state);
+}
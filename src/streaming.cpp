@@ -0,0 +1,484 @@
+#include "streaming.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+struct RunRecord {
+    int64_t id;
+    uint32_t count;
+};
+
+void writeRecord(std::ofstream& out, const RunRecord& r) {
+    out.write(reinterpret_cast<const char*>(&r.id), sizeof(r.id));
+    out.write(reinterpret_cast<const char*>(&r.count), sizeof(r.count));
+}
+
+// Sorts buffered input ids and writes them to a run file as (id, consumer count) records
+bool writeRun(std::vector<int64_t>& ids, const std::string& path, std::string& error) {
+    std::sort(ids.begin(), ids.end());
+    std::ofstream out(path, std::ios::binary);
+    if (!out) { error = "Cannot write run file: " + path; return false; }
+    for (size_t i = 0; i < ids.size();) {
+        RunRecord r{ids[i], 0};
+        for (; i < ids.size() && ids[i] == r.id; ++i) ++r.count;
+        writeRecord(out, r);
+    }
+    ids.clear();
+    return static_cast<bool>(out);
+}
+
+// K-way merge over run files: yields each id once, in increasing order, with its counts summed
+class RunMerger {
+public:
+    bool open(const std::vector<std::string>& paths, std::string& error) {
+        for (const auto& p : paths) {
+            runs_.push_back(std::make_unique<std::ifstream>(p, std::ios::binary));
+            if (!*runs_.back()) { error = "Cannot read run file: " + p; return false; }
+            advance(runs_.size() - 1);
+        }
+        return true;
+    }
+    bool next(RunRecord& out) {
+        if (heap_.empty()) return false;
+        out = RunRecord{heap_.top().id, 0};
+        while (!heap_.empty() && heap_.top().id == out.id) {
+            Head h = heap_.top(); heap_.pop();
+            out.count += h.count;
+            advance(h.run);
+        }
+        return true;
+    }
+private:
+    struct Head {
+        int64_t id; uint32_t count; size_t run;
+        bool operator>(const Head& o) const { return id > o.id; }
+    };
+    void advance(size_t run) {
+        RunRecord r{};
+        std::ifstream& in = *runs_[run];
+        if (in.read(reinterpret_cast<char*>(&r.id), sizeof(r.id)) &&
+            in.read(reinterpret_cast<char*>(&r.count), sizeof(r.count))) {
+            heap_.push({r.id, r.count, run});
+        }
+    }
+    std::vector<std::unique_ptr<std::ifstream>> runs_;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap_;
+};
+
+// Consumer counts from the final runs, queried with non-decreasing ids
+class ConsumerCounts {
+public:
+    bool open(const std::vector<std::string>& paths, std::string& error) {
+        if (!merger_.open(paths, error)) return false;
+        has_ = merger_.next(head_);
+        return true;
+    }
+    uint32_t consumersOf(int64_t id) {
+        while (has_ && head_.id < id) has_ = merger_.next(head_); // smaller ids were never defined as rows
+        return has_ && head_.id == id ? head_.count : 0;
+    }
+private:
+    RunMerger merger_;
+    RunRecord head_{};
+    bool has_{false};
+};
+
+struct Pending {
+    ExamplesRow row;
+    uint32_t consumers{0};
+};
+
+// A row whose output may still be read: live (consumers left to run), or read out and kept
+// (recent, or needed to recompute an evicted output). Inputs are narrowed to the tracked ones
+// when the row first runs; the rest were never defined.
+struct Live {
+    ExamplesRow row;
+    uint32_t remaining{0};  // consumers that have not run yet
+    uint32_t dependents{0}; // evicted or read-out rows that read it when recomputed
+    bool resident{true};
+    bool evictable{true};   // false once an input row was dropped: a rerun could not get it back
+    uint64_t used{0};       // last run or read, for LRU eviction
+};
+
+} // namespace
+
+// Pass 1: validate id order and spill consumer counts to sorted runs
+static bool countConsumers(const std::string& input_path, const std::string& order_path, const StreamOptions& opts,
+                           std::vector<std::string>& runs, StreamStats& stats, std::string& error) {
+    std::ifstream in(input_path);
+    if (!in) { error = "Failed to open input: " + input_path; return false; }
+    std::string line;
+    if (!std::getline(in, line) || !parseExamplesHeader(line, stats.total_memory)) {
+        error = "Expected 'Return <total_memory>' header";
+        return false;
+    }
+    std::vector<int64_t> buffer;
+    buffer.reserve(std::min<size_t>(opts.run_edges, 1u << 20));
+    ExamplesRow row;
+    int64_t last = std::numeric_limits<int64_t>::min();
+    while (std::getline(in, line)) {
+        if (!parseExamplesRow(line, row)) continue;
+        if (row.id <= last) { error = "Rows must appear in increasing id order (id " + std::to_string(row.id) + ")"; return false; }
+        last = row.id;
+        ++stats.nodes;
+        for (long iid : row.inputs) {
+            if (iid < 0) continue;
+            if (iid >= row.id) { error = "Input " + std::to_string(iid) + " of id " + std::to_string(row.id) + " is not earlier"; return false; }
+            buffer.push_back(iid);
+            if (buffer.size() >= std::max<size_t>(opts.run_edges, 1)) {
+                runs.push_back(order_path + ".run" + std::to_string(runs.size()));
+                if (!writeRun(buffer, runs.back(), error)) return false;
+            }
+        }
+    }
+    if (!buffer.empty()) {
+        runs.push_back(order_path + ".run" + std::to_string(runs.size()));
+        if (!writeRun(buffer, runs.back(), error)) return false;
+    }
+    if (stats.nodes == 0) { error = "No nodes parsed"; return false; }
+    return true;
+}
+
+// Merges runs `fan_in` at a time until at most `fan_in` remain, so pass 2 holds a fixed number
+// of open files and heap entries however many runs pass 1 wrote.
+static bool mergeRuns(std::vector<std::string>& runs, const std::string& order_path, size_t fanIn,
+                      size_t& created, StreamStats& stats, std::string& error) {
+    fanIn = std::max<size_t>(fanIn, 2);
+    while (runs.size() > fanIn) {
+        std::vector<std::string> merged;
+        for (size_t i = 0; i < runs.size(); i += fanIn) {
+            std::vector<std::string> group(runs.begin() + static_cast<long>(i),
+                                           runs.begin() + static_cast<long>(std::min(i + fanIn, runs.size())));
+            if (group.size() == 1) { merged.push_back(group[0]); continue; }
+            merged.push_back(order_path + ".run" + std::to_string(created++));
+            RunMerger in;
+            if (!in.open(group, error)) return false;
+            std::ofstream out(merged.back(), std::ios::binary);
+            if (!out) { error = "Cannot write run file: " + merged.back(); return false; }
+            for (RunRecord r; in.next(r);) writeRecord(out, r);
+            if (!out) { error = "Write failed: " + merged.back(); return false; }
+            for (const auto& p : group) std::remove(p.c_str());
+        }
+        runs.swap(merged);
+        ++stats.merge_passes;
+    }
+    return true;
+}
+
+// Pass 2: windowed greedy over the rows, appending each step to the order file. Under memory
+// pressure the least recently used resident output goes first, preferring ones no pending row
+// reads, as OnlineScheduler does; a later read recomputes it. An output is read out once its
+// last consumer runs, as in replaySchedule, but the last `history` read-out rows are kept so a
+// rerun can recompute them in turn; rows an evicted output depends on are never dropped. Before
+// a row whose output cannot be recomputed is read out, the evicted outputs depending on it are
+// recomputed, so a rerun never needs a dropped row.
+static bool emitSchedule(const std::string& input_path, const std::string& order_path, const StreamOptions& opts,
+                         ConsumerCounts& counts, StreamStats& stats, std::string& error) {
+    std::ifstream in(input_path);
+    std::ofstream out(order_path);
+    if (!in) { error = "Failed to open input: " + input_path; return false; }
+    if (!out) { error = "Cannot write order file: " + order_path; return false; }
+    std::string line;
+    std::getline(in, line); // header, checked in pass 1
+
+    const size_t window = std::max<size_t>(opts.window, 1);
+    std::deque<Pending> pending;
+    std::unordered_set<int64_t> pendingIds;
+    std::unordered_map<int64_t, uint32_t> windowUses;           // reads by pending rows
+    std::unordered_map<int64_t, Live> live;
+    std::deque<int64_t> history;                                // read-out rows kept, oldest first
+    std::set<std::pair<uint64_t, int64_t>> lru;                 // resident evictable outputs by last use
+    std::unordered_map<int64_t, uint32_t> pins;                 // inputs of rows being materialized
+    std::unordered_map<int64_t, std::vector<int64_t>> waiting;  // input -> rows that depended on it
+    long current = 0;
+    size_t residentCount = 0, kept = 0;
+    uint64_t clock = 0;
+    bool eof = false;
+
+    auto touch = [&](int64_t id, Live& l) {
+        bool listed = l.resident && l.evictable;
+        if (listed) lru.erase({l.used, id});
+        l.used = ++clock;
+        if (listed) lru.emplace(l.used, id);
+    };
+    // Whether a rerun of `l` finds every row it needs, through the ones off the device or in
+    // `leaving` (read out by the row being materialized); with `pinned`, also that none of them
+    // is pinned (that row may read it out)
+    std::vector<int64_t> below, leaving;
+    std::unordered_set<int64_t> seen;
+    auto rerunnable = [&](const Live& l, bool pinned) {
+        below.assign(l.row.inputs.begin(), l.row.inputs.end());
+        seen.clear();
+        while (!below.empty()) {
+            int64_t x = below.back();
+            below.pop_back();
+            if (!seen.insert(x).second) continue;
+            auto it = live.find(x);
+            if (it == live.end() || (pinned && pins.count(x))) return false;
+            bool off = !it->second.resident || std::find(leaving.begin(), leaving.end(), x) != leaving.end();
+            if (off) below.insert(below.end(), it->second.row.inputs.begin(), it->second.row.inputs.end());
+        }
+        return true;
+    };
+    // A row off the device that will be recomputed holds its inputs; holding a read-out row
+    // makes it hold its own inputs in turn
+    std::vector<std::pair<int64_t, int>> holds;
+    auto hold = [&](int64_t id, int delta) {
+        holds.assign(1, {id, delta});
+        while (!holds.empty()) {
+            auto [y, d] = holds.back();
+            holds.pop_back();
+            for (long x : live.at(y).row.inputs) {
+                Live& lx = live.at(x);
+                if (d > 0) waiting[x].push_back(y);
+                lx.dependents += d;
+                bool edge = d > 0 ? lx.dependents == 1 : lx.dependents == 0;
+                if (edge && !lx.resident && lx.remaining == 0) holds.emplace_back(x, d);
+            }
+        }
+    };
+    auto erase = [&](int64_t id) {
+        waiting.erase(id);
+        pins.erase(id);
+        live.erase(id);
+        --kept;
+    };
+    // Takes a read-out output off the device; the row stays while something depends on it, and
+    // among the last `history` rows when its inputs are still there
+    auto readOut = [&](int64_t id, Live& l, bool first) {
+        lru.erase({l.used, id});
+        current -= l.row.output_mem;
+        --residentCount;
+        l.resident = false;
+        if (l.dependents) hold(id, 1);
+        if (!first) return;
+        ++kept;
+        bool tracked = true;
+        for (long x : l.row.inputs) if (!live.count(x)) { tracked = false; break; }
+        if (!tracked && !l.dependents) { erase(id); return; }
+        history.push_back(id);
+    };
+    // Drops the oldest read-out rows beyond `history` that nothing depends on; runs once a row
+    // has read all its inputs, since reading out a later one may still hold an earlier one's rows
+    auto trim = [&]() {
+        for (size_t n = history.size(); kept > opts.history && n > 0; --n) {
+            int64_t h = history.front();
+            history.pop_front();
+            const Live& lh = live.at(h);
+            if (lh.resident || lh.dependents) history.push_back(h); // still needed
+            else erase(h);
+        }
+    };
+    // Evicts one output, cold before warm; false when none can be recomputed later
+    auto evictOne = [&]() {
+        for (int pass = 0; pass < 2; ++pass) {
+            for (auto it = lru.begin(); it != lru.end();) {
+                int64_t id = it->second;
+                if (pins.count(id) || (pass == 0 && windowUses.count(id))) { ++it; continue; }
+                Live& l = live.at(id);
+                bool direct = true; // a dropped input never comes back
+                for (long x : l.row.inputs) if (!live.count(x)) { direct = false; break; }
+                if (!direct) { l.evictable = false; it = lru.erase(it); continue; }
+                if (!rerunnable(l, true)) { ++it; continue; }
+                lru.erase(it);
+                current -= l.row.output_mem;
+                --residentCount;
+                l.resident = false;
+                hold(id, 1);
+                ++stats.evictions;
+                return true;
+            }
+        }
+        return false;
+    };
+    auto pin = [&](const ExamplesRow& r, bool on) {
+        for (long x : r.inputs) {
+            if (!live.count(x)) continue;
+            if (on) ++pins[x];
+            else if (--pins[x] == 0) pins.erase(x);
+        }
+    };
+    // Runs a row whose tracked inputs are resident: makes room, charges it and reads its inputs,
+    // reading out those with no consumers left
+    auto run = [&](const ExamplesRow& r, uint32_t consumers, bool recompute) {
+        const long need = std::max(r.run_mem, r.output_mem);
+        while (current + need > stats.total_memory && evictOne()) {}
+        stats.memory_peak = std::max(stats.memory_peak, current + need);
+        stats.total_time += r.time_cost;
+        current += r.output_mem;
+        out << r.name << "_id" << r.id << (recompute ? "*" : "") << "\n";
+        std::vector<long> inputs; // distinct tracked inputs, kept for a rerun
+        for (long iid : r.inputs) {
+            auto it = live.find(iid);
+            if (it == live.end()) continue; // never defined as a row
+            if (std::find(inputs.begin(), inputs.end(), iid) != inputs.end()) continue;
+            inputs.push_back(iid);
+            Live& l = it->second;
+            touch(iid, l);
+            if (!recompute) --l.remaining;
+            if (l.remaining == 0 && l.resident) readOut(iid, l, !recompute);
+        }
+        if (recompute) {
+            Live& l = live.at(r.id);
+            l.resident = true;
+            ++residentCount;
+            if (l.remaining || l.dependents) hold(r.id, -1);
+            touch(r.id, l);
+            ++stats.recomputes;
+            return;
+        }
+        trim();
+        if (consumers == 0) {
+            current -= r.output_mem;
+        } else {
+            Live& l = live[r.id];
+            l.row = r;
+            l.row.inputs = std::move(inputs);
+            l.remaining = consumers;
+            ++residentCount;
+            touch(r.id, l);
+        }
+    };
+    // Recomputes `x`, and whatever it reads that is off the device, depth first
+    std::vector<int64_t> stack;
+    auto restore = [&](int64_t x) {
+        stack.assign(1, x);
+        pin(live.at(x).row, true);
+        while (!stack.empty()) {
+            Live& y = live.at(stack.back());
+            if (y.resident) { pin(y.row, false); stack.pop_back(); continue; }
+            bool ready = true;
+            for (long z : y.row.inputs) {
+                Live& lz = live.at(z);
+                if (!lz.resident) { stack.push_back(z); pin(lz.row, true); ready = false; }
+            }
+            if (!ready) continue;
+            ExamplesRow row = y.row;
+            stack.pop_back();
+            run(row, 0, true);
+            pin(row, false);
+        }
+    };
+    // Evicted live outputs that depend on `x`, directly or through read-out rows
+    std::vector<int64_t> up, evicted;
+    auto evictedDependents = [&](int64_t x) {
+        up.assign(1, x);
+        seen.clear();
+        evicted.clear();
+        while (!up.empty()) {
+            auto w = waiting.find(up.back());
+            up.pop_back();
+            if (w == waiting.end()) continue;
+            for (int64_t d : w->second) {
+                auto ld = live.find(d);
+                if (ld == live.end() || ld->second.resident || !seen.insert(d).second) continue;
+                if (ld->second.remaining) evicted.push_back(d);
+                else if (ld->second.dependents) up.push_back(d);
+            }
+        }
+        return evicted;
+    };
+    // Brings back the evicted inputs of a pending row, and the outputs depending on an input it
+    // reads out that could not be recomputed afterwards, then runs it
+    auto materialize = [&](const Pending& node) {
+        pin(node.row, true);
+        for (long x : node.row.inputs) {
+            auto it = live.find(x);
+            if (it != live.end() && !it->second.resident) restore(x);
+        }
+        for (long x : node.row.inputs) {
+            auto it = live.find(x);
+            if (it != live.end() && it->second.remaining <= static_cast<uint32_t>(std::count(node.row.inputs.begin(), node.row.inputs.end(), x)))
+                leaving.push_back(x);
+        }
+        for (long x : leaving) {
+            auto it = live.find(x);
+            if (it == live.end() || !it->second.dependents || rerunnable(it->second, false)) continue;
+            std::vector<int64_t> back = evictedDependents(x);
+            for (int64_t y : back) {
+                auto ly = live.find(y);
+                if (ly != live.end() && !ly->second.resident) restore(y);
+            }
+        }
+        leaving.clear();
+        run(node.row, node.consumers, false);
+        pin(node.row, false);
+    };
+
+    while (true) {
+        while (!eof && pending.size() < window) {
+            if (!std::getline(in, line)) { eof = true; break; }
+            Pending p;
+            if (!parseExamplesRow(line, p.row)) continue;
+            p.consumers = counts.consumersOf(p.row.id);
+            pendingIds.insert(p.row.id);
+            for (long iid : p.row.inputs) ++windowUses[iid];
+            pending.push_back(std::move(p));
+        }
+        if (pending.empty()) break;
+
+        // A ready node that does not grow memory (smallest peak first) is pulled forward;
+        // otherwise the earliest ready row runs. Reordering growing nodes by predicted peak
+        // opens extra branches and raised the example5 peak with wider windows.
+        size_t pick = 0; bool pickedNegative = false, found = false;
+        long bestPeak = std::numeric_limits<long>::max();
+        for (size_t i = 0; i < pending.size(); ++i) {
+            const ExamplesRow& r = pending[i].row;
+            bool ready = true; long freed = 0;
+            for (size_t k = 0; k < r.inputs.size(); ++k) {
+                const long iid = r.inputs[k];
+                if (pendingIds.count(iid)) { ready = false; break; }
+                if (std::find(r.inputs.begin(), r.inputs.begin() + static_cast<long>(k), iid) != r.inputs.begin() + static_cast<long>(k)) continue;
+                auto it = live.find(iid);
+                if (it == live.end() || !it->second.resident) continue; // never defined as a row, or evicted
+                if (it->second.remaining <= static_cast<uint32_t>(std::count(r.inputs.begin(), r.inputs.end(), iid))) freed += it->second.row.output_mem;
+            }
+            if (!ready) continue;
+            long nodePeak = std::max(r.run_mem, r.output_mem);
+            if (r.output_mem - freed <= 0) {
+                if (!pickedNegative || nodePeak < bestPeak) { pick = i; bestPeak = nodePeak; pickedNegative = found = true; }
+                continue;
+            }
+            if (!found) { pick = i; found = true; } // otherwise keep file order
+        }
+
+        Pending node = std::move(pending[pick]);
+        pending.erase(pending.begin() + static_cast<long>(pick));
+        pendingIds.erase(node.row.id);
+        for (long iid : node.row.inputs) {
+            auto it = windowUses.find(iid);
+            if (--it->second == 0) windowUses.erase(it);
+        }
+        materialize(node);
+        stats.max_resident = std::max(stats.max_resident, residentCount);
+    }
+    if (!out) { error = "Write failed: " + order_path; return false; }
+    return true;
+}
+
+bool streamSchedule(const std::string& input_path, const std::string& order_path,
+                    const StreamOptions& opts, StreamStats& stats, std::string& error) {
+    stats = StreamStats{};
+    std::vector<std::string> runs;
+    bool ok = countConsumers(input_path, order_path, opts, runs, stats, error);
+    stats.runs = runs.size();
+    size_t created = runs.size(); // run files are numbered in creation order
+    ok = ok && mergeRuns(runs, order_path, opts.merge_fan_in, created, stats, error);
+    if (ok) {
+        ConsumerCounts counts;
+        ok = counts.open(runs, error) && emitSchedule(input_path, order_path, opts, counts, stats, error);
+    }
+    for (size_t k = 0; k < created; ++k) std::remove((order_path + ".run" + std::to_string(k)).c_str());
+    return ok;
+}
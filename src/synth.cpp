@@ -0,0 +1,60 @@
+#include "synth.hpp"
+#include "features.hpp"
+#include <algorithm>
+#include <random>
+
+static const char* const kOpStems[] = {
+    "MatMul", "Add", "Mul", "Softmax", "Transpose", "Cast", "Equal", "DropoutDoMask",
+};
+
+Problem generateSyntheticProblem(const SynthOptions& opts) {
+    std::mt19937 rng(opts.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> sizeExp(18, 23);
+    std::uniform_int_distribution<int> timeDist(20, 1000);
+    std::uniform_int_distribution<size_t> stemDist(0, sizeof(kOpStems) / sizeof(kOpStems[0]) - 1);
+
+    ProblemBuilder builder(0);
+    builder.reserve(opts.nodes, opts.nodes * 2);
+    std::vector<NodeId> ins;
+    for (size_t i = 0; i < opts.nodes; ++i) {
+        std::string stem = std::string(kOpStems[stemDist(rng)]) + "-op0";
+        int output_mem = 1 << sizeExp(rng);
+        int run_mem = unit(rng) < 0.2 ? (1 << sizeExp(rng)) : 0;
+        int time_cost = timeDist(rng);
+        builder.addNode(stem, static_cast<uint32_t>(i), run_mem, output_mem, time_cost);
+        if (i == 0 || unit(rng) < 0.05) continue; // occasional new source
+        ins.clear();
+        if (unit(rng) < opts.chain_prob) {
+            ins.push_back(static_cast<NodeId>(i - 1));
+        } else {
+            size_t window = std::min(i, std::max<size_t>(opts.locality, 1));
+            std::uniform_int_distribution<size_t> back(1, window);
+            size_t fanIn = 1 + rng() % std::max<size_t>(opts.max_fan_in, 1);
+            for (size_t k = 0; k < fanIn; ++k) {
+                NodeId in = static_cast<NodeId>(i - back(rng));
+                if (std::find(ins.begin(), ins.end(), in) == ins.end()) ins.push_back(in);
+            }
+        }
+        for (NodeId in : ins) builder.addInput(in);
+    }
+    Problem prob = builder.finish();
+    // Ids are topological, so the FIFO sweep is the id-order sweep
+    prob.total_memory = static_cast<long>(static_cast<double>(topologicalSweepPeak(prob)) * opts.budget_factor);
+    return prob;
+}
+
+std::vector<ParsedNodeSpec> generateSyntheticGraph(const SynthOptions& opts, long& total_memory) {
+    Problem prob = generateSyntheticProblem(opts);
+    std::vector<ParsedNodeSpec> specs(prob.size());
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        ParsedNodeSpec& s = specs[id];
+        s.name = prob.name(id);
+        s.run_mem = prob.nodes[id].getRunMem();
+        s.output_mem = prob.nodes[id].getOutputMem();
+        s.time_cost = prob.nodes[id].getTimeCost();
+        for (NodeId in : prob.inputs(id)) s.inputs.push_back(prob.name(in));
+    }
+    total_memory = prob.total_memory;
+    return specs;
+}
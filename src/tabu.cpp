@@ -0,0 +1,505 @@
+#include "tabu.hpp"
+#include "decode.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+
+// Decode plus the per-step profile the evaluator works on
+struct Decoded {
+    ScheduleState state;
+    std::vector<long> before;     // resident memory before step t
+    std::vector<long> peak;       // before[t] + peak of the node run at step t
+    std::vector<uint32_t> entry;  // order index being processed at step t
+    std::vector<uint32_t> slot;   // first step of order index i
+    bool complete{false};
+};
+
+// Dropped outputs are recomputed on demand; the step profile is recorded as the decode runs
+struct DropPolicy {
+    const Problem& prob;
+    const NodeBitset& drop;
+    Decoded& d;
+    uint32_t i{0};
+    void enter(size_t entry) {
+        i = static_cast<uint32_t>(entry);
+        d.slot.push_back(static_cast<uint32_t>(d.before.size()));
+    }
+    bool onDemand(NodeId v) const { return drop.test(v); }
+    bool kept(NodeId id) const { return !drop.test(id); }
+    void beforeRun(NodeId id) {
+        d.before.push_back(d.state.current_memory);
+        d.peak.push_back(stepPeak(prob, id, d.state));
+        d.entry.push_back(i);
+    }
+    void afterRun(NodeId) {}
+    bool restore(NodeId) { return false; }
+    void release(NodeId x) { spillOutput(prob, d.state, x); }
+};
+
+bool decode(const Problem& prob, const std::vector<NodeId>& order, const NodeBitset& drop, Decoded& d) {
+    d.state = ScheduleState{};
+    d.before.clear(); d.peak.clear(); d.entry.clear(); d.slot.clear();
+    DropPolicy policy{prob, drop, d};
+    d.complete = decodeFirstRunOrder(prob, order, d.state, policy);
+    return d.complete;
+}
+
+const long kNone = std::numeric_limits<long>::min() / 4;
+const long kGone = std::numeric_limits<long>::max() / 64; // subtracted from steps a flip removes
+
+bool present(long v) { return v > kNone / 2; }
+
+// Range add / range max over the step profile. Adds stay at the nodes they cover (no push-down),
+// so queries are const and workers can screen flips while nothing is being applied.
+class ProfileTree {
+public:
+    void build(const std::vector<long>& v) {
+        n_ = v.size();
+        size_ = 1;
+        while (size_ < std::max<size_t>(1, n_)) size_ <<= 1;
+        t_.assign(2 * size_, kNone);
+        add_.assign(2 * size_, 0);
+        std::copy(v.begin(), v.end(), t_.begin() + static_cast<std::ptrdiff_t>(size_));
+        for (size_t i = size_; i-- > 1;) t_[i] = std::max(t_[2 * i], t_[2 * i + 1]);
+    }
+    void add(size_t l, size_t r, long delta) { if (l < r) add(1, 0, size_, l, std::min(r, n_), delta); } // [l, r)
+    long query(size_t l, size_t r) const { return l < r ? query(1, 0, size_, l, std::min(r, n_)) : kNone; }
+    long max() const { return t_[1]; }
+    // Point i becomes at least `value` (as seen through every add above it)
+    void raise(size_t i, long value) {
+        std::vector<size_t> path;
+        for (size_t v = (i + size_) >> 1; v >= 1; v >>= 1) path.push_back(v);
+        long above = 0;
+        for (size_t v : path) above += add_[v];
+        size_t leaf = i + size_;
+        t_[leaf] = std::max(t_[leaf], value - above);
+        for (size_t v : path) t_[v] = std::max(t_[2 * v], t_[2 * v + 1]) + add_[v];
+    }
+    size_t argmax() const {
+        size_t v = 1;
+        while (v < size_) v = t_[2 * v] >= t_[2 * v + 1] ? 2 * v : 2 * v + 1;
+        return v - size_;
+    }
+private:
+    void add(size_t v, size_t lo, size_t hi, size_t l, size_t r, long delta) {
+        if (r <= lo || hi <= l) return;
+        if (l <= lo && hi <= r) { t_[v] += delta; add_[v] += delta; return; }
+        size_t mid = (lo + hi) / 2;
+        add(2 * v, lo, mid, l, r, delta);
+        add(2 * v + 1, mid, hi, l, r, delta);
+        t_[v] = std::max(t_[2 * v], t_[2 * v + 1]) + add_[v];
+    }
+    long query(size_t v, size_t lo, size_t hi, size_t l, size_t r) const {
+        if (r <= lo || hi <= l) return kNone;
+        if (l <= lo && hi <= r) return t_[v];
+        size_t mid = (lo + hi) / 2;
+        long m = std::max(query(2 * v, lo, mid, l, r), query(2 * v + 1, mid, hi, l, r));
+        return present(m) ? m + add_[v] : kNone;
+    }
+    size_t n_{0}, size_{1};
+    std::vector<long> t_, add_;
+};
+
+// Range add / point query (Fenwick over differences) for the resident memory before each step
+class ShiftTree {
+public:
+    void reset(size_t n) { f_.assign(n + 2, 0); }
+    void add(size_t l, size_t r, long delta) { bump(l, delta); bump(r, -delta); } // [l, r)
+    long at(size_t i) const {
+        long s = 0;
+        for (size_t k = i + 1; k > 0; k -= k & (~k + 1)) s += f_[k];
+        return s;
+    }
+private:
+    void bump(size_t i, long delta) { for (size_t k = i + 1; k < f_.size(); k += k & (~k + 1)) f_[k] += delta; }
+    std::vector<long> f_;
+};
+
+struct Cost {
+    long over{0}; // peak above the budget
+    long time{0};
+    bool operator<(const Cost& o) const { return over != o.over ? over < o.over : time < o.time; }
+};
+
+Cost costOf(const Problem& prob, long peak, long time) {
+    return {std::max(0L, peak - prob.total_memory), time};
+}
+
+struct Add { uint32_t a, b; long delta; }; // delta over steps [a, b]
+
+// What a flip does to the profile: range adds, steps that disappear and new run steps
+// (position, memory on top of the resident memory there)
+struct Flip {
+    NodeId node{kNoNode};
+    std::vector<Add> adds;
+    std::vector<uint32_t> removed;
+    std::vector<std::pair<uint32_t, long>> runs;
+    long time{0};
+    Cost cost;
+    long critAfter{0};       // profile at the step being relieved, after the flip
+    bool approximate{false}; // a recompute cascade was charged in time only
+};
+
+// Incremental view of one decode: per-node runs, uses and residency segments in step order,
+// and the profile with the flips applied since the decode
+struct Profile {
+    const Problem& prob;
+    const Decoded& d;
+    ProfileTree tree;
+    ProfileTree extra; // run steps added by applied flips, by the step they precede
+    ShiftTree shift;
+    long time{0};
+    std::vector<uint32_t> runOff, runs, useOff, uses;
+    std::vector<uint32_t> orderPos;
+    struct Segment { uint32_t a, b; NodeId node; };
+    std::vector<Segment> segments;
+
+    Profile(const Problem& p, const Decoded& dec, const std::vector<NodeId>& order) : prob(p), d(dec), time(dec.state.total_time) {
+        tree.build(d.peak);
+        extra.build(std::vector<long>(d.peak.size(), kNone));
+        shift.reset(d.peak.size());
+        const auto& steps = d.state.execution_order;
+        runOff.assign(prob.size() + 1, 0);
+        useOff.assign(prob.size() + 1, 0);
+        for (const ScheduleStep& st : steps) {
+            ++runOff[st.node() + 1];
+            for (NodeId x : prob.inputs(st.node())) ++useOff[x + 1];
+        }
+        for (size_t v = 0; v < prob.size(); ++v) { runOff[v + 1] += runOff[v]; useOff[v + 1] += useOff[v]; }
+        runs.resize(runOff.back());
+        uses.resize(useOff.back());
+        std::vector<uint32_t> rfill(runOff.begin(), runOff.end() - 1), ufill(useOff.begin(), useOff.end() - 1);
+        for (uint32_t t = 0; t < steps.size(); ++t) {
+            runs[rfill[steps[t].node()]++] = t;
+            for (NodeId x : prob.inputs(steps[t].node())) uses[ufill[x]++] = t;
+        }
+        orderPos.assign(prob.size(), 0);
+        for (uint32_t i = 0; i < order.size(); ++i) orderPos[order[i]] = i;
+        for (NodeId x = 0; x < prob.size(); ++x) {
+            forEachSegment(x, [&](uint32_t a, uint32_t b) { segments.push_back({a, b, x}); });
+        }
+    }
+
+    uint32_t steps() const { return static_cast<uint32_t>(d.peak.size()); }
+    long beforeAt(uint32_t t) const { return t < steps() ? d.before[t] + shift.at(t) : 0; }
+    long peakNow() const { return std::max({tree.max(), extra.max(), 0L}); }
+
+    // Residency segments [a, b] (steps where the output counts in `before`): from each run to
+    // the last use before the next run
+    template <class F>
+    void forEachSegment(NodeId x, F&& f) const {
+        size_t u = useOff[x];
+        for (size_t r = runOff[x]; r < runOff[x + 1]; ++r) {
+            uint32_t a = runs[r] + 1, next = r + 1 < runOff[x + 1] ? runs[r + 1] : std::numeric_limits<uint32_t>::max();
+            while (u < useOff[x + 1] && uses[u] < a) ++u;
+            uint32_t b = 0;
+            bool any = false;
+            for (; u < useOff[x + 1] && uses[u] < next; ++u) { b = uses[u]; any = true; }
+            if (any) f(a, b);
+        }
+    }
+    bool residentAt(NodeId x, uint32_t t) const {
+        bool hit = false;
+        forEachSegment(x, [&](uint32_t a, uint32_t b) { if (a <= t && t <= b) hit = true; });
+        return hit;
+    }
+
+    void apply(const Flip& f) {
+        for (const Add& ad : f.adds) {
+            tree.add(ad.a, ad.b + 1, ad.delta);
+            extra.add(ad.a, ad.b + 1, ad.delta);
+            shift.add(ad.a, ad.b + 1, ad.delta);
+        }
+        for (uint32_t r : f.removed) tree.add(r, r + 1, -kGone);
+        for (const auto& e : f.runs) {
+            if (e.first < steps()) extra.raise(e.first, beforeAt(e.first) + e.second);
+        }
+        time = f.time;
+    }
+};
+
+long deltaAt(const std::vector<Add>& adds, uint32_t t) {
+    long delta = 0;
+    for (const Add& ad : adds) if (ad.a <= t && t <= ad.b) delta += ad.delta;
+    return delta;
+}
+
+// Peak of the current profile once `f` is applied on top
+long flipPeak(const Profile& pf, const Flip& f) {
+    std::vector<uint32_t> cuts{0, pf.steps()};
+    for (const Add& ad : f.adds) { cuts.push_back(ad.a); cuts.push_back(ad.b + 1); }
+    for (uint32_t r : f.removed) { cuts.push_back(r); cuts.push_back(r + 1); }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+    long best = kNone;
+    for (size_t k = 0; k + 1 < cuts.size() && cuts[k] < pf.steps(); ++k) {
+        uint32_t l = cuts[k], r = std::min(cuts[k + 1], pf.steps());
+        long delta = deltaAt(f.adds, l);
+        long e = pf.extra.query(l, r); // run steps of applied flips are never removed
+        if (present(e)) best = std::max(best, e + delta);
+        if (r == l + 1 && std::find(f.removed.begin(), f.removed.end(), l) != f.removed.end()) continue;
+        long m = pf.tree.query(l, r);
+        if (present(m)) best = std::max(best, m + delta);
+    }
+    for (const auto& e : f.runs) best = std::max(best, pf.beforeAt(e.first) + deltaAt(f.adds, e.first) + e.second);
+    return std::max(best, 0L);
+}
+
+// Screens flipping `x` against the profile in `pf`: dropping runs it before each group of uses
+// sharing an order entry, keeping runs it once at its slot and holds it to its last use
+Flip estimateFlip(const Profile& pf, const NodeBitset& drop, NodeId x, uint32_t crit) {
+    const Problem& prob = pf.prob;
+    const Node& node = prob.nodes[x];
+    const long out = node.getOutputMem();
+    Flip f;
+    f.node = x;
+    f.removed.assign(pf.runs.begin() + pf.runOff[x], pf.runs.begin() + pf.runOff[x + 1]);
+    // Both sides keep exactly one first run, so only the count of re-runs changes the time
+    const long rerun = prob.recomputeCost(x);
+    f.time = pf.time - static_cast<long>(f.removed.size()) * rerun;
+    pf.forEachSegment(x, [&](uint32_t a, uint32_t b) { f.adds.push_back({a, b, -out}); });
+    std::vector<std::pair<uint32_t, uint32_t>> groups;
+    if (!drop.test(x)) {
+        for (size_t u = pf.useOff[x]; u < pf.useOff[x + 1]; ++u) {
+            uint32_t t = pf.uses[u];
+            if (!groups.empty() && pf.d.entry[groups.back().second] == pf.d.entry[t]) groups.back().second = t;
+            else groups.emplace_back(t, t);
+        }
+    } else {
+        uint32_t s = pf.d.slot[pf.orderPos[x]];
+        uint32_t last = pf.useOff[x + 1] > pf.useOff[x] ? pf.uses[pf.useOff[x + 1] - 1] : s;
+        groups.emplace_back(s, std::max(s, last));
+    }
+    for (const auto& g : groups) f.adds.push_back({g.first, g.second, out});
+    f.time += static_cast<long>(groups.size()) * rerun;
+
+    // Inputs must be resident at every new run: the first keeps them alive longer, the later
+    // ones recompute them if nothing else holds them (a cascade charged in time only)
+    for (NodeId y : prob.inputs(x)) {
+        uint32_t heldUntil = 0;
+        for (size_t g = 0; g < groups.size(); ++g) {
+            uint32_t at = groups[g].first;
+            if ((g > 0 && at <= heldUntil) || pf.residentAt(y, at)) continue;
+            bool extended = false;
+            if (g == 0 && !f.removed.empty()) {
+                pf.forEachSegment(y, [&](uint32_t a, uint32_t b) {
+                    if (!extended && a <= f.removed.front() && f.removed.front() <= b && b < at) {
+                        f.adds.push_back({b + 1, at, prob.nodes[y].getOutputMem()});
+                        heldUntil = at;
+                        extended = true;
+                    }
+                });
+            }
+            if (!extended) {
+                f.time += prob.recomputeCost(y);
+                f.approximate = true;
+            }
+        }
+    }
+    for (const auto& g : groups) f.runs.emplace_back(g.first, node.getPeak() - out);
+    f.cost = costOf(prob, flipPeak(pf, f), f.time);
+    f.critAfter = crit < pf.steps() ? pf.tree.query(crit, crit + 1) + deltaAt(f.adds, crit) : 0;
+    return f;
+}
+
+// Flips worth screening: over budget, outputs held across step `crit` (most memory per unit of
+// recompute first); within budget also dropped outputs (most recompute time per byte first).
+std::vector<NodeId> candidates(const Profile& pf, const NodeBitset& drop, uint32_t crit, bool feasible,
+                               const NodeBitset* touched, size_t limit) {
+    const Problem& prob = pf.prob;
+    std::vector<std::pair<double, NodeId>> scored;
+    const NodeId critNode = crit < pf.steps() ? pf.d.state.execution_order[crit].node() : kNoNode;
+    auto stale = [&](NodeId x) {
+        if (!touched) return false;
+        if (touched->test(x)) return true;
+        for (NodeId y : prob.inputs(x)) if (touched->test(y)) return true;
+        return false;
+    };
+    if (feasible) {
+        drop.forEach([&](NodeId x) {
+            if (prob.consumers(x).empty() || stale(x)) return;
+            double reruns = static_cast<double>(pf.runOff[x + 1] - pf.runOff[x]);
+            scored.emplace_back(-static_cast<double>(prob.recomputeCost(x)) * reruns / std::max(1, prob.nodes[x].getOutputMem()), x);
+        });
+    }
+    auto in = critNode != kNoNode ? prob.inputs(critNode) : IdRange{nullptr, nullptr};
+    for (const auto& sg : pf.segments) {
+        if (crit < sg.a || sg.b < crit) continue;
+        NodeId x = sg.node;
+        const Node& n = prob.nodes[x];
+        if (drop.test(x) || x == critNode || n.getOutputMem() <= 0 || stale(x)) continue;
+        if (std::find(in.begin(), in.end(), x) != in.end()) continue;
+        scored.emplace_back(-static_cast<double>(n.getOutputMem()) / std::max(1, prob.recomputeCost(x)), x);
+    }
+    std::sort(scored.begin(), scored.end());
+    if (scored.size() > limit) scored.resize(limit);
+    std::vector<NodeId> ids;
+    for (const auto& s : scored) ids.push_back(s.second);
+    return ids;
+}
+
+uint32_t critStep(const Profile& pf) {
+    return static_cast<uint32_t>(pf.extra.max() > pf.tree.max() ? pf.extra.argmax() : pf.tree.argmax());
+}
+
+} // namespace
+
+std::vector<NodeId> firstRunOrder(const Problem& prob, const ScheduleState& seed) {
+    std::vector<NodeId> order;
+    NodeBitset placed;
+    for (const ScheduleStep& st : seed.execution_order) {
+        if (!st.isRecompute() && !placed.test(st.node())) { order.push_back(st.node()); placed.set(st.node()); }
+    }
+    if (order.size() == prob.size()) return order;
+    // Complete a partial seed with Kahn's algorithm over the rest
+    std::vector<uint32_t> missing(prob.size(), 0);
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < prob.size(); ++id) {
+        if (placed.test(id)) continue;
+        for (NodeId in : prob.inputs(id)) if (!placed.test(in)) ++missing[id];
+        if (missing[id] == 0) ready.push_back(id);
+    }
+    for (size_t k = 0; k < ready.size(); ++k) {
+        NodeId id = ready[k];
+        order.push_back(id);
+        for (NodeId c : prob.consumers(id)) {
+            if (!placed.test(c) && --missing[c] == 0) ready.push_back(c);
+        }
+    }
+    return order;
+}
+
+ScheduleState decodeDrops(const Problem& prob, const std::vector<NodeId>& order, const NodeBitset& drop) {
+    Decoded d;
+    decode(prob, order, drop, d);
+    return std::move(d.state);
+}
+
+ScheduleState tabuSchedule(const Problem& prob, const ScheduleState& seed, const TabuOptions& opts, TabuStats* stats) {
+    TabuStats local;
+    TabuStats& st = stats ? *stats : local;
+    st = TabuStats{};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(opts.time_limit > 0.0 ? opts.time_limit : 5.0));
+    const std::vector<NodeId> order = firstRunOrder(prob, seed);
+    if (order.size() != prob.size()) return ScheduleState{};
+
+    NodeBitset drop;
+    Decoded cur;
+    if (!decode(prob, order, drop, cur)) return ScheduleState{};
+    ++st.decodes;
+    st.start_peak = cur.state.memory_peak;
+    st.start_time = cur.state.total_time;
+    Cost curCost = costOf(prob, cur.state.memory_peak, cur.state.total_time);
+    Decoded best = cur;
+    NodeBitset bestDrop = drop;
+    Cost bestCost = curCost;
+    std::vector<size_t> tabuUntil(prob.size(), 0);
+    size_t batch = std::max<size_t>(1, opts.batch);
+
+    auto screen = [&](const Profile& pf, const NodeBitset& dropped, const std::vector<NodeId>& ids, uint32_t crit) {
+        std::vector<Flip> flips(ids.size());
+        parallelFor(ids.size(), opts.threads, [&](size_t k, size_t) { flips[k] = estimateFlip(pf, dropped, ids[k], crit); });
+        st.screened += ids.size();
+        for (const Flip& f : flips) if (f.approximate) ++st.approximate;
+        return flips;
+    };
+    auto accept = [&](Decoded&& next, NodeBitset&& nextDrop, Cost c) {
+        drop = std::move(nextDrop);
+        cur = std::move(next);
+        curCost = c;
+        if (c < bestCost) {
+            bestCost = c;
+            best = cur;
+            bestDrop = drop;
+            ++st.improvements;
+        }
+    };
+
+    for (size_t it = 1; it <= opts.max_iterations && std::chrono::steady_clock::now() < deadline; ++it) {
+        st.iterations = it;
+        Profile pf(prob, cur, order);
+        const bool feasible = curCost.over == 0;
+
+        // Over budget: chain drops on the incremental profile, each relieving the step that is
+        // currently highest, and decode once for the whole chain
+        if (!feasible && batch > 1) {
+            NodeBitset chained = drop, touched;
+            size_t applied = 0;
+            long lastPeak = pf.peakNow();
+            while (applied < batch && lastPeak > prob.total_memory) {
+                uint32_t crit = critStep(pf);
+                auto ids = candidates(pf, chained, crit, false, &touched, opts.neighborhood);
+                if (ids.empty()) break;
+                auto flips = screen(pf, chained, ids, crit);
+                const Flip* pick = nullptr;
+                for (const Flip& f : flips) {
+                    if (tabuUntil[f.node] >= it) continue;
+                    auto key = [](const Flip& g) { return std::make_tuple(g.cost.over, g.critAfter, g.cost.time); };
+                    if (!pick || key(f) < key(*pick)) pick = &f;
+                }
+                long critNow = pf.tree.query(crit, crit + 1);
+                if (!pick || pick->cost.over > lastPeak - prob.total_memory || pick->critAfter >= critNow) break;
+                pf.apply(*pick);
+                touched.set(pick->node);
+                for (NodeId y : prob.inputs(pick->node)) touched.set(y);
+                chained.set(pick->node);
+                lastPeak = pick->cost.over + prob.total_memory;
+                ++applied;
+            }
+            if (applied > 0) {
+                Decoded next;
+                decode(prob, order, chained, next);
+                ++st.decodes;
+                Cost c = costOf(prob, next.state.memory_peak, next.state.total_time);
+                if (next.complete && c < curCost) {
+                    chained.forEach([&](NodeId x) { if (!drop.test(x)) tabuUntil[x] = it + opts.tenure; });
+                    accept(std::move(next), std::move(chained), c);
+                    continue;
+                }
+            }
+            batch = std::max<size_t>(1, batch / 2); // the chained estimates drifted too far
+            if (applied > 0) continue;
+        }
+
+        // One flip: screen the neighborhood, decode the best few exactly, take the best non-tabu
+        uint32_t crit = critStep(pf);
+        auto ids = candidates(pf, drop, crit, feasible, nullptr, opts.neighborhood);
+        if (ids.empty()) break;
+        auto flips = screen(pf, drop, ids, crit);
+        std::vector<size_t> rank;
+        for (size_t k = 0; k < flips.size(); ++k) {
+            // Tabu flips stay eligible when their estimate beats the best (aspiration)
+            if (tabuUntil[flips[k].node] < it || flips[k].cost < bestCost) rank.push_back(k);
+        }
+        if (rank.empty()) continue;
+        size_t keep = std::min(std::max<size_t>(1, opts.exact), rank.size());
+        std::stable_sort(rank.begin(), rank.end(), [&](size_t a, size_t b) { return flips[a].cost < flips[b].cost; });
+        rank.resize(keep);
+
+        std::vector<Decoded> trial(keep);
+        std::vector<NodeBitset> trialDrop(keep, drop);
+        parallelFor(keep, opts.threads, [&](size_t k, size_t) {
+            NodeId x = flips[rank[k]].node;
+            if (trialDrop[k].test(x)) trialDrop[k].reset(x); else trialDrop[k].set(x);
+            decode(prob, order, trialDrop[k], trial[k]);
+        });
+        st.decodes += keep;
+        size_t pick = keep;
+        Cost pickCost{};
+        for (size_t k = 0; k < keep; ++k) {
+            if (!trial[k].complete) continue;
+            Cost c = costOf(prob, trial[k].state.memory_peak, trial[k].state.total_time);
+            if (tabuUntil[flips[rank[k]].node] >= it && !(c < bestCost)) continue;
+            if (pick == keep || c < pickCost) { pick = k; pickCost = c; }
+        }
+        if (pick == keep) continue;
+        tabuUntil[flips[rank[pick]].node] = it + opts.tenure;
+        accept(std::move(trial[pick]), std::move(trialDrop[pick]), pickCost);
+    }
+    st.dropped = bestDrop.count();
+    return std::move(best.state);
+}
@@ -0,0 +1,245 @@
+#include "tiers.hpp"
+#include "decode.hpp"
+#include "tabu.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+bool loadTierConfig(const std::string& path, TierConfig& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) { error = "Failed to open tier file: " + path; return false; }
+    TierConfig cfg;
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::stringstream ss(line);
+        MemoryTier t;
+        std::string cap, bw, extra;
+        if (!(ss >> t.name)) continue;
+        const std::string where = " on line " + std::to_string(line_no) + " of " + path;
+        if (!(ss >> cap >> bw) || (ss >> extra)) { error = "Expected '<name> <capacity> <bandwidth>'" + where; return false; }
+        try {
+            if (cap != "-") t.capacity = std::stol(cap);
+            t.bandwidth = std::stod(bw);
+        } catch (...) { error = "Invalid number" + where; return false; }
+        // Only the fast tier may keep the input's budget; lower tiers need a way back
+        if ((cap == "-" && !cfg.tiers.empty()) || (cap != "-" && t.capacity < 0)) { error = "Invalid capacity" + where; return false; }
+        if (t.bandwidth < 0.0 || (!cfg.tiers.empty() && t.bandwidth <= 0.0)) { error = "Invalid bandwidth" + where; return false; }
+        cfg.tiers.push_back(std::move(t));
+    }
+    if (cfg.tiers.empty()) { error = "No tiers in " + path; return false; }
+    if (cfg.tiers.size() > 255) { error = "Too many tiers in " + path; return false; }
+    out = std::move(cfg);
+    return true;
+}
+
+void applyTierConfig(const TierConfig& tiers, Problem& prob) {
+    if (!tiers.tiers.empty() && tiers.tiers[0].capacity >= 0) prob.total_memory = tiers.tiers[0].capacity;
+}
+
+long tierTransferTime(const MemoryTier& tier, long bytes) {
+    return static_cast<long>(std::ceil(static_cast<double>(bytes) / tier.bandwidth));
+}
+
+TieredSchedule decodeTierPlan(const Problem& prob, const TierConfig& tiers, const std::vector<NodeId>& order,
+                              const std::vector<StorageAction>& plan, bool slow, TierStats* stats) {
+    TierStats local;
+    TierStats& st = stats ? *stats : local;
+    st.demotions = st.promotions = st.recomputes = 0;
+    st.migration_time = 0;
+
+    // Recomputed and offloaded outputs leave after their uses; offloaded ones migrate to a lower
+    // tier and come back by promotion, the rest are dropped
+    struct Policy {
+        const Problem& prob;
+        const TierConfig& tiers;
+        const std::vector<StorageAction>& plan;
+        bool slow;
+        TierStats& st;
+        TieredSchedule& out;
+        std::vector<long> used;     // bytes per lower tier
+        std::vector<uint8_t> where; // lower tier holding a copy; 0 = none
+        StorageAction action(NodeId x) const { return x < plan.size() ? plan[x] : StorageAction::Keep; }
+        void move(NodeId x, TierMoveKind kind, size_t tier) {
+            out.moves.push_back({static_cast<uint32_t>(out.state.execution_order.size()), x, kind, static_cast<uint8_t>(tier)});
+        }
+        void migrate(NodeId x, size_t tier) {
+            long t = tierTransferTime(tiers.tiers[tier], prob.nodes[x].getOutputMem());
+            out.state.total_time += t;
+            st.migration_time += t;
+        }
+        void enter(size_t) {}
+        bool onDemand(NodeId v) const { return action(v) == StorageAction::Recompute; }
+        bool kept(NodeId id) const { return action(id) != StorageAction::Recompute && action(id) != StorageAction::Offload; }
+        void beforeRun(NodeId id) { if (out.state.computed.test(id)) ++st.recomputes; }
+        void afterRun(NodeId id) {
+            for (NodeId x : prob.inputs(id)) {
+                if (where[x] && !hasPendingConsumer(prob, x, out.state)) { used[where[x]] -= prob.nodes[x].getOutputMem(); where[x] = 0; }
+            }
+        }
+        bool restore(NodeId x) {
+            if (!where[x]) return false;
+            ScheduleState& s = out.state;
+            migrate(x, where[x]);
+            ++st.promotions;
+            move(x, TierMoveKind::Promote, where[x]);
+            s.resident.set(x);
+            s.current_memory += prob.nodes[x].getOutputMem();
+            s.memory_peak = std::max(s.memory_peak, s.current_memory);
+            return true;
+        }
+        // Migrated outputs leave for the fastest lower tier with room (with !slow, only while its
+        // round trips beat recomputation), or are dropped and recomputed
+        void release(NodeId x) {
+            ScheduleState& s = out.state;
+            if (action(x) == StorageAction::Recompute || where[x]) { move(x, TierMoveKind::Drop, 0); spillOutput(prob, s, x); return; }
+            const long bytes = prob.nodes[x].getOutputMem();
+            const long later = std::max<long>(1, static_cast<long>(prob.consumers(x).size()) - 1);
+            const long recompute = static_cast<long>(prob.recomputeCost(x)) * later;
+            for (size_t t = 1; t < tiers.tiers.size(); ++t) {
+                if (used[t] + bytes > tiers.tiers[t].capacity) continue;
+                if (!slow && tierTransferTime(tiers.tiers[t], bytes) * (1 + later) > recompute) break; // slower tiers cost more
+                migrate(x, t);
+                ++st.demotions;
+                move(x, TierMoveKind::Demote, t);
+                used[t] += bytes;
+                out.tier_peak[t] = std::max(out.tier_peak[t], used[t]);
+                where[x] = static_cast<uint8_t>(t);
+                spillOutput(prob, s, x);
+                return;
+            }
+            move(x, TierMoveKind::Drop, 0);
+            spillOutput(prob, s, x);
+        }
+    };
+    TieredSchedule out;
+    const size_t T = tiers.tiers.size();
+    out.tier_peak.assign(T, 0);
+    Policy policy{prob, tiers, plan, slow, st, out, std::vector<long>(T, 0), std::vector<uint8_t>(prob.size(), 0)};
+    decodeFirstRunOrder(prob, order, out.state, policy);
+    if (T) out.tier_peak[0] = out.state.memory_peak;
+    return out;
+}
+
+TieredSchedule tieredSchedule(const Problem& prob, const TierConfig& tiers, const ScheduleState& seed,
+                              const TierOptions& opts, TierStats* stats) {
+    TierStats local;
+    TierStats& st = stats ? *stats : local;
+    st = TierStats{};
+    const std::vector<NodeId> order = firstRunOrder(prob, seed);
+
+    // Migration pays one demotion plus a promotion per later use; its cost per byte only
+    // depends on the tier, so the fastest lower tier decides against recomputation
+    const double perByte = tiers.tiers.size() > 1 ? 1.0 / tiers.tiers[1].bandwidth : -1.0;
+    const std::vector<StorageOption> ranked = rankStorageOptions(prob, perByte, false);
+
+    struct Probe {
+        TieredSchedule sched;
+        TierStats stats;
+    };
+    size_t probes = 0;
+    auto search = [&](bool slow, size_t limit, TierStats& bestStats) {
+        auto decode = [&](size_t k) {
+            Probe p;
+            p.sched = decodeTierPlan(prob, tiers, order, storagePrefixPlan(prob, ranked, k), slow, &p.stats);
+            return p;
+        };
+        Probe best = searchStoragePrefix(prob, ranked.size(), limit, probes, decode,
+                                         [](const Probe& p) -> const ScheduleState& { return p.sched.state; });
+        bestStats = best.stats;
+        return std::move(best.sched);
+    };
+    auto fits = [&](const TieredSchedule& t) {
+        return t.state.computed.count() == prob.size() && t.state.memory_peak <= prob.total_memory;
+    };
+    // Falling through to slow tiers avoids recompute cascades but can cost more than they do;
+    // with more than one lower tier both policies get half the probes
+    const bool both = tiers.tiers.size() > 2;
+    TierStats bestStats;
+    TieredSchedule best = search(true, both ? opts.max_probes / 2 : opts.max_probes, bestStats);
+    if (both) {
+        TierStats ps;
+        TieredSchedule t = search(false, opts.max_probes - opts.max_probes / 2, ps);
+        if (fits(t) && (!fits(best) || t.state.total_time < best.state.total_time)) { best = std::move(t); bestStats = ps; }
+    }
+    bestStats.probes = probes;
+    bestStats.fits = fits(best);
+    st = bestStats;
+    return best;
+}
+
+bool validateTieredSchedule(const Problem& prob, const TierConfig& tiers, const TieredSchedule& sched,
+                            std::string& error, TieredSchedule* replayed) {
+    const size_t T = tiers.tiers.size();
+    if (T == 0) { error = "No tiers"; return false; }
+    TieredSchedule r;
+    ScheduleState& s = r.state;
+    r.tier_peak.assign(T, 0);
+    std::vector<long> used(T, 0);
+    std::vector<uint8_t> where(prob.size(), 0);
+    const std::vector<ScheduleStep>& order = sched.state.execution_order;
+    size_t m = 0;
+    auto applyMoves = [&](size_t step) {
+        for (; m < sched.moves.size() && sched.moves[m].step <= step; ++m) {
+            const TierMove& mv = sched.moves[m];
+            const std::string at = " at step " + std::to_string(step);
+            if (mv.step < step) { error = "Moves out of order" + at; return false; }
+            if (mv.node >= prob.size() || mv.tier >= T) { error = "Invalid move" + at; return false; }
+            const long bytes = prob.nodes[mv.node].getOutputMem();
+            const std::string name = prob.name(mv.node);
+            if (mv.kind == TierMoveKind::Promote) {
+                if (s.resident.test(mv.node) || mv.tier == 0 || where[mv.node] != mv.tier) {
+                    error = "Promote of " + name + " not held in " + tiers.tiers[mv.tier].name + at;
+                    return false;
+                }
+                s.total_time += tierTransferTime(tiers.tiers[mv.tier], bytes);
+                s.resident.set(mv.node);
+                s.current_memory += bytes;
+                s.memory_peak = std::max(s.memory_peak, s.current_memory);
+                r.moves.push_back(mv);
+                continue;
+            }
+            if (!s.resident.test(mv.node)) { error = "Move of " + name + " not in the fast tier" + at; return false; }
+            if (mv.kind == TierMoveKind::Demote) {
+                if (mv.tier == 0 || where[mv.node]) { error = "Demote of " + name + " to " + tiers.tiers[mv.tier].name + at; return false; }
+                s.total_time += tierTransferTime(tiers.tiers[mv.tier], bytes);
+                used[mv.tier] += bytes;
+                r.tier_peak[mv.tier] = std::max(r.tier_peak[mv.tier], used[mv.tier]);
+                if (used[mv.tier] > tiers.tiers[mv.tier].capacity) {
+                    error = "Tier " + tiers.tiers[mv.tier].name + " over capacity" + at;
+                    return false;
+                }
+                where[mv.node] = mv.tier;
+            }
+            spillOutput(prob, s, mv.node);
+            r.moves.push_back(mv);
+        }
+        return true;
+    };
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (!applyMoves(i)) return false;
+        const NodeId id = order[i].node();
+        const std::string at = " at step " + std::to_string(i);
+        if (id >= prob.size()) { error = "Invalid node" + at; return false; }
+        if (order[i].isRecompute() != s.computed.test(id)) { error = "Recompute flag of " + prob.name(id) + at; return false; }
+        for (NodeId x : prob.inputs(id)) {
+            if (!s.resident.test(x)) { error = "Input " + prob.name(x) + " of " + prob.name(id) + " not in the fast tier" + at; return false; }
+        }
+        applyNode(id, prob, s);
+        for (NodeId x : prob.inputs(id)) {
+            if (where[x] && !hasPendingConsumer(prob, x, s)) { used[where[x]] -= prob.nodes[x].getOutputMem(); where[x] = 0; }
+        }
+        if (prob.consumers(id).empty()) spillOutput(prob, s, id);
+    }
+    if (!applyMoves(order.size())) return false;
+    if (m != sched.moves.size()) { error = "Moves after the last step"; return false; }
+    if (s.computed.count() != prob.size()) { error = "Not every node runs"; return false; }
+    r.tier_peak[0] = s.memory_peak;
+    if (s.memory_peak > prob.total_memory) { error = "Tier " + tiers.tiers[0].name + " over capacity"; return false; }
+    if (replayed) *replayed = std::move(r);
+    return true;
+}
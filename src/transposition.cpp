@@ -0,0 +1,88 @@
+#include "transposition.hpp"
+
+static uint64_t mix64(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// Bitsets grow on demand, so equal sets may differ in trailing zero words; hash set words only
+static uint64_t hashWords(uint64_t h, const std::vector<uint64_t>& words) {
+    for (size_t i = 0; i < words.size(); ++i) if (words[i]) h = mix64(mix64(h, i), words[i]);
+    return h;
+}
+
+uint64_t stateKey(const ScheduleState& state) {
+    uint64_t h = hashWords(0, state.computed.words());
+    h = hashWords(mix64(h, 0x5bd1e995ull), state.resident.words());
+    return h ? h : 1;
+}
+
+TranspositionTable::TranspositionTable(size_t entries) {
+    size_t n = 1;
+    while (n < entries) n <<= 1;
+    slots_.resize(n);
+    mask_ = n - 1;
+}
+
+bool TranspositionTable::dominated(uint64_t key, long g, long peak, size_t budget) const {
+    const Entry& e = slots_[key & mask_];
+    return e.key == key && e.g <= g && e.peak <= peak && e.budget >= budget;
+}
+
+void TranspositionTable::store(uint64_t key, long g, long peak, size_t budget) {
+    Entry& e = slots_[key & mask_];
+    // Same state: keep the record that is faster, or as fast with no higher peak, unless it was
+    // searched with less budget; a different state simply takes the slot over
+    if (e.key == key && e.budget >= budget && (e.g < g || (e.g == g && e.peak <= peak))) return;
+    e.key = key; e.g = g; e.peak = peak; e.budget = budget;
+}
+
+static uint64_t checkWord(uint64_t key, uint64_t g, uint64_t peak) {
+    return key ^ g ^ (peak * 0x9e3779b97f4a7c15ull);
+}
+
+ConcurrentTranspositionTable::ConcurrentTranspositionTable(size_t entries) {
+    size_t n = kProbe;
+    while (n < entries) n <<= 1;
+    slots_ = HugeVector<Entry>(n);
+    mask_ = n - 1;
+}
+
+bool ConcurrentTranspositionTable::dominated(uint64_t key, long g, long peak) const {
+    for (size_t i = 0; i < kProbe; ++i) {
+        const Entry& e = slots_[(key + i) & mask_];
+        uint64_t eg = e.g.load(std::memory_order_relaxed), ep = e.peak.load(std::memory_order_relaxed);
+        if (e.check.load(std::memory_order_relaxed) != checkWord(key, eg, ep)) continue;
+        return static_cast<long>(eg) <= g && static_cast<long>(ep) <= peak;
+    }
+    return false;
+}
+
+void ConcurrentTranspositionTable::store(uint64_t key, long g, long peak) {
+    Entry* victim = nullptr;
+    uint64_t victimG = 0;
+    for (size_t i = 0; i < kProbe; ++i) {
+        Entry& e = slots_[(key + i) & mask_];
+        uint64_t eg = e.g.load(std::memory_order_relaxed), ep = e.peak.load(std::memory_order_relaxed);
+        uint64_t c = e.check.load(std::memory_order_relaxed);
+        if (c == checkWord(key, eg, ep)) {
+            // Same state: keep the faster record, or the as fast one with no higher peak
+            if (static_cast<long>(eg) < g || (static_cast<long>(eg) == g && static_cast<long>(ep) <= peak)) return;
+            victim = &e;
+            break;
+        }
+        if (c == 0 && eg == 0 && ep == 0) { victim = &e; break; }
+        if (!victim || eg > victimG) { victim = &e; victimG = eg; }
+    }
+    victim->g.store(static_cast<uint64_t>(g), std::memory_order_relaxed);
+    victim->peak.store(static_cast<uint64_t>(peak), std::memory_order_relaxed);
+    victim->check.store(checkWord(key, static_cast<uint64_t>(g), static_cast<uint64_t>(peak)), std::memory_order_relaxed);
+}
+
+void ConcurrentTranspositionTable::clear() {
+    for (size_t i = 0; i <= mask_; ++i) {
+        slots_[i].check.store(0, std::memory_order_relaxed);
+        slots_[i].g.store(0, std::memory_order_relaxed);
+        slots_[i].peak.store(0, std::memory_order_relaxed);
+    }
+}
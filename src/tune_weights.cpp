@@ -0,0 +1,102 @@
+#include "parallel.hpp"
+#include "parser.hpp"
+#include "scheduler.hpp"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+// Offline tuner for prioritySchedule weights.
+// (1+1) evolution strategy with the 1/5th success rule; each candidate is scored on every
+// input in parallel and the best weights are written in loadPriorityWeights format.
+
+struct TuneOptions {
+    size_t iterations{200};
+    size_t threads{0};
+    unsigned seed{1};
+    double sigma{0.5};
+    std::string output{"weights.txt"};
+    std::string init;
+    std::vector<std::string> inputs;
+};
+
+static double evaluate(const std::vector<Problem>& problems, const PriorityWeights& pw, size_t threads) {
+    std::vector<double> scores(problems.size(), 0.0);
+    parallelFor(problems.size(), threads, [&](size_t i, size_t) {
+        scores[i] = relativeScheduleCost(problems[i], prioritySchedule(problems[i], pw));
+    });
+    double total = 0.0;
+    for (double sc : scores) total += sc;
+    return problems.empty() ? 0.0 : total / problems.size();
+}
+
+static bool parseArgs(int argc, char** argv, TuneOptions& opts) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string a = argv[i];
+            auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+            const char* v = nullptr;
+            if (a == "--iters" && (v = value())) opts.iterations = std::stoul(v);
+            else if (a == "--threads" && (v = value())) opts.threads = std::stoul(v);
+            else if (a == "--seed" && (v = value())) opts.seed = static_cast<unsigned>(std::stoul(v));
+            else if (a == "--sigma" && (v = value())) opts.sigma = std::stod(v);
+            else if (a == "--init" && (v = value())) opts.init = v;
+            else if (a == "-o" && (v = value())) opts.output = v;
+            else if (!a.empty() && a[0] == '-') return false;
+            else opts.inputs.push_back(a);
+        }
+    } catch (const std::exception&) {
+        return false; // malformed number
+    }
+    return !opts.inputs.empty();
+}
+
+int main(int argc, char** argv) {
+    TuneOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::cout << "Usage: tune_weights [--iters N] [--threads T] [--seed S] [--sigma X] "
+                     "[--init weights.txt] [-o weights.txt] <input_file>...\n";
+        return 0;
+    }
+    if (opts.threads == 0) opts.threads = defaultThreadCount();
+
+    std::vector<Problem> problems;
+    for (const auto& path : opts.inputs) {
+        Problem prob; std::string error;
+        if (!loadProblemFile(path, prob, error)) {
+            std::cerr << "Parse error in " << path << ": " << error << "\n";
+            return 2;
+        }
+        problems.push_back(std::move(prob));
+    }
+
+    PriorityWeights best = defaultPriorityWeights();
+    if (!opts.init.empty()) {
+        std::string error;
+        if (!loadPriorityWeights(opts.init, best, error)) { std::cerr << error << "\n"; return 1; }
+    }
+    double bestScore = evaluate(problems, best, opts.threads);
+    std::cout << "initial score=" << bestScore << "\n";
+
+    std::mt19937 rng(opts.seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    double sigma = opts.sigma;
+    for (size_t it = 0; it < opts.iterations; ++it) {
+        PriorityWeights cand = best;
+        for (int f = 0; f < PF_Count; ++f) cand.w[f] += sigma * gauss(rng);
+        double sc = evaluate(problems, cand, opts.threads);
+        if (sc < bestScore) {
+            best = cand; bestScore = sc;
+            sigma *= 1.5;
+            std::cout << "iter " << it << " score=" << bestScore << " sigma=" << sigma << "\n";
+        } else {
+            sigma *= std::pow(1.5, -0.25);
+        }
+        if (sigma < 1e-4) sigma = opts.sigma; // restart the step size once it collapses
+    }
+
+    std::string error;
+    if (!savePriorityWeights(opts.output, best, error)) { std::cerr << error << "\n"; return 1; }
+    std::cout << "best score=" << bestScore << " written to " << opts.output << "\n";
+    return 0;
+}